@@ -0,0 +1,115 @@
+// bench_binary.cpp
+// バイナリ形式とテキスト形式のファイル出力の比較
+// 同じ行をPlainFmt + FileWriterとBinaryFmt + BinaryFileWriterで書き、
+// 1行あたりの時間とファイルサイズを計測する。バイナリ形式で整形を
+// 省くにはLOG_DEFERREDが必要。
+// 先に、遅延フォーマット（バイナリへの詰め直しを含む）がsnprintfと同じ
+// 文字列になることを確認する（違えば終了コード1）。
+//
+//   g++ -std=c++14 -O2 -pthread -DLOG_DEFERRED=1 bench/bench_binary.cpp -o bench_binary
+//   ./bench_binary [出力先ディレクトリ]
+//   g++ -std=c++14 -O2 -pthread tools/log_decode.cpp -o log_decode
+//   ./log_decode -p 出力先ディレクトリ/bench_binary.bin   # 残したバイナリを表示
+
+#include "../logger.hpp"
+#include <chrono>
+#include <string>
+
+using namespace logger;
+
+namespace {
+
+const int LINES = 1000000;
+
+enum Direction { DOWN = -1, UP = 1 };
+enum class Mode : int { IDLE = 0, FAULT = -3 };
+
+/**
+ * @brief 引数を遅延フォーマットした結果がsnprintfと同じか確認
+ * @details Deferred::formatと、pack_args/unpack_argsを通した後の両方を見る
+ * @return 一致すればtrue
+ */
+template <typename... Args>
+bool check_format(const char* fmt, const Args&... args) {
+    char payload[LOG_MSG_SIZE];
+    char packed[LOG_MSG_SIZE];
+    char unpacked[LOG_MSG_SIZE];
+    char expect[LOG_MSG_SIZE];
+    char direct[LOG_MSG_SIZE];
+    char via_binary[LOG_MSG_SIZE];
+    size_t len = Deferred::encode(payload, sizeof(payload), args...);
+    snprintf(expect, sizeof(expect), fmt, args...);
+    Deferred::format(fmt, payload, len, direct, sizeof(direct));
+    len = Binary::pack_args(payload, len, packed, sizeof(packed));
+    len = Binary::unpack_args(packed, len, unpacked, sizeof(unpacked));
+    Deferred::format(fmt, unpacked, len, via_binary, sizeof(via_binary));
+    if (strcmp(expect, direct) != 0 || strcmp(expect, via_binary) != 0) {
+        printf("MISMATCH(%s): \"%s\" / \"%s\" / \"%s\"\n", fmt, expect,
+               direct, via_binary);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 符号と幅の扱いが即時フォーマットと同じか確認
+ * @return 全て一致すればtrue
+ */
+bool check_deferred() {
+    bool ok = true;
+    ok &= check_format("u=%u x=%x hx=%hx", -1, -1, static_cast<short>(-2));
+    ok &= check_format("d=%d hhd=%hhd hhu=%hhu", 4000000000u, 300, -1);
+    ok &= check_format("ld=%ld lu=%lu llx=%llx zu=%zu", -5L, -5L, -1LL,
+                       static_cast<size_t>(-1));
+    ok &= check_format("c=%c o=%o X=%08X", 'A', static_cast<unsigned char>(255),
+                       static_cast<uint16_t>(0xbeef));
+    ok &= check_format("%*d|%-*.*u", 6, -42, 8, 3, 7u);
+    ok &= check_format("dir=%d mode=%d", DOWN, Mode::FAULT);
+    ok &= check_format("%s %.3f %p", "text", 2.5, static_cast<void*>(nullptr));
+    printf("deferred: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+/**
+ * @brief LINES行を書いてflushするまでの時間とファイルサイズを表示
+ */
+void run(const char* name, const std::string& path,
+         Formatters::FormatterBase* formatter, Writers::IWriter* writer) {
+    Logger log{std::unique_ptr<Formatters::FormatterBase>(formatter),
+               std::unique_ptr<Writers::IWriter>(writer)};
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LINES; i++) {
+        LOG_TO(log, LogLevel::INFO_, "request %d served in %d us by worker %s",
+               i, i % 977, "io-3");
+    }
+    log.flush();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    FILE* file = fopen(path.c_str(), "rb");
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file);
+    fclose(file);
+    printf("%-8s %8.1f ns/log %8.1f bytes/line %8.1f MB\n", name, ns / LINES,
+           static_cast<double>(bytes) / LINES, bytes / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (!check_deferred()) {
+        return 1;
+    }
+    std::string dir = argc > 1 ? argv[1] : ".";
+    std::string text = dir + "/bench_binary.log";
+    std::string binary = dir + "/bench_binary.bin";
+    remove(text.c_str());
+    remove(binary.c_str());
+
+    run("text", text, new Formatters::PlainFmt(),
+        new Writers::FileWriter(text.c_str()));
+    run("binary", binary, new Formatters::BinaryFmt(),
+        new Writers::BinaryFileWriter(binary.c_str()));
+    remove(text.c_str());
+    return 0;
+}
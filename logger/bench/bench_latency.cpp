@@ -0,0 +1,268 @@
+// bench_latency.cpp
+// 呼び出し1回の遅延分布（裾）の計測
+// LOG_*の各呼び出しをrdtscで挟み、スレッド毎の対数線形ヒストグラム
+// （HDR方式、誤差約3%）へ記録して、p50 / p99 / p99.9 / 最大を表示する。
+// 平均では見えない停止（出力中のスレッドが詰まる、flushが割り込むなど）を
+// 非同期化やロックフリー化の前後で比べるためのもの。
+//
+// シナリオ（出力はPlainFmt、標準出力へ書くwriterは/dev/nullへ捨てる）:
+//   steady      BufferedWriterへ連続して出力
+//   flush       別スレッドが1ms毎にflushを呼ぶ
+//   slow_sink   1回の出力に200usかかるwriter
+//   console     1行毎にprintfするConsoleWriter
+//   bursty      1000行出しては2ms休む
+//
+//   g++ -std=c++14 -O2 -pthread bench/bench_latency.cpp -o bench_latency
+//   g++ -std=c++14 -O2 -pthread -DLOG_ASYNC=1 bench/bench_latency.cpp -o bench_latency
+//   ./bench_latency [最大スレッド数] [1スレッドあたりの回数]
+
+#include "../logger.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace logger;
+
+namespace {
+
+/**
+ * @brief 現在のtick（TSCが使えなければsteady_clockのns）
+ */
+inline uint64_t ticks() {
+#if LOG_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+/**
+ * @brief 対数線形ヒストグラム
+ * @details 2の冪毎の区間をSUB_COUNT個に等分する。64未満はそのまま数え、
+ * それ以上は上位6ビットで区間を決めるので相対誤差は1/32以下。
+ * 記録は配列の加算1回（スレッド毎に持ち、最後に合算する）
+ */
+class alignas(64) Histogram {
+   private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int LINEAR = SUB_COUNT * 2;  // そのまま数える範囲
+    static constexpr int BUCKETS = LINEAR + (64 - SUB_BITS - 1) * SUB_COUNT;
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+
+    static int index(uint64_t v) {
+        if (v < LINEAR) {
+            return static_cast<int>(v);
+        }
+        const int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+        return LINEAR + (shift - 1) * SUB_COUNT +
+               static_cast<int>((v >> shift) - SUB_COUNT);
+    }
+
+    // 区間の上端（値を小さく見積もらないように）
+    static uint64_t upper(int i) {
+        if (i < LINEAR) {
+            return static_cast<uint64_t>(i);
+        }
+        const int shift = (i - LINEAR) / SUB_COUNT + 1;
+        const uint64_t top = static_cast<uint64_t>((i - LINEAR) % SUB_COUNT) +
+                             SUB_COUNT;
+        return ((top + 1) << shift) - 1;
+    }
+
+   public:
+    void record(uint64_t v) {
+        counts[index(v)]++;
+        total++;
+        max_value = std::max(max_value, v);
+    }
+
+    void merge(const Histogram& other) {
+        for (int i = 0; i < BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        max_value = std::max(max_value, other.max_value);
+    }
+
+    /**
+     * @brief 分位点（q: 0〜1）
+     */
+    uint64_t percentile(double q) const {
+        const uint64_t rank = static_cast<uint64_t>(q * total);
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > rank) {
+                return std::min(upper(i), max_value);
+            }
+        }
+        return max_value;
+    }
+
+    uint64_t max() const { return max_value; }
+};
+
+/**
+ * @brief 1回の出力にdelay_usかかるwriter（遅いUARTやディスクの代わり）
+ */
+class SlowWriter : public Writers::BaseBufferedWriter {
+   private:
+    int delay_us;
+
+   public:
+    explicit SlowWriter(int delay_us) : delay_us(delay_us) {}
+    ~SlowWriter() override { flush(); }
+
+   protected:
+    void output(const Chunk* chunks, int n) override {
+        (void)chunks;
+        (void)n;
+        std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+    }
+};
+
+enum Scenario { STEADY, FLUSH, SLOW_SINK, CONSOLE, BURSTY, SCENARIO_COUNT };
+const char* const SCENARIO_NAMES[] = {"steady", "flush", "slow_sink", "console",
+                                      "bursty"};
+
+const int BURST = 1000;     // burstyで1度に出す行数
+const int BURST_GAP_MS = 2;  // burstyの休み
+const int FLUSH_MS = 1;      // flushシナリオの間隔
+const int SLOW_US = 200;     // slow_sinkの1回の出力時間
+
+void produce(Logger& log, Scenario scenario, int tid, int calls,
+             Histogram& hist) {
+    for (int i = 0; i < calls; i++) {
+        if (scenario == BURSTY && i % BURST == 0 && i != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(BURST_GAP_MS));
+        }
+        const uint64_t start = ticks();
+        LOG_TO(log, LogLevel::INFO_, "T%d sample %d value %.3f", tid, i,
+               i * 0.125);
+        hist.record(ticks() - start);
+    }
+}
+
+/**
+ * @brief 1シナリオを測り、合算したヒストグラムを返す
+ */
+Histogram run(Scenario scenario, int threads, int calls) {
+    Writers::IWriter* writer;
+    if (scenario == SLOW_SINK) {
+        writer = new SlowWriter(SLOW_US);
+    } else if (scenario == CONSOLE) {
+        writer = new Writers::ConsoleWriter();
+    } else {
+        writer = new Writers::BufferedWriter();
+    }
+    Logger log{std::unique_ptr<Formatters::FormatterBase>(
+                   new Formatters::PlainFmt()),
+               std::unique_ptr<Writers::IWriter>(writer)};
+#if LOG_ASYNC
+    log.start_async();
+#endif
+
+    std::vector<Histogram> hists(threads);
+    std::atomic<bool> done{false};
+    std::thread flusher;
+    if (scenario == FLUSH) {
+        flusher = std::thread([&] {
+            while (!done.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_MS));
+                log.flush();
+            }
+        });
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back(
+            [&, t] { produce(log, scenario, t, calls, hists[t]); });
+    }
+    for (auto& th : pool) {
+        th.join();
+    }
+    done.store(true);
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    log.flush();
+
+    Histogram merged;
+    for (const Histogram& h : hists) {
+        merged.merge(h);
+    }
+    return merged;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 4;
+    int calls = argc > 2 ? atoi(argv[2]) : 100000;
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    if (calls < 1) {
+        calls = 100000;
+    }
+    // 表は標準エラーへ、ログ出力は/dev/nullへ
+    if (freopen("/dev/null", "w", stdout) == nullptr) {
+        return 1;
+    }
+    Time::now();  // 較正を計測から外す
+
+    // tickとnsの比をこの実行全体で求める
+    const auto steady0 = std::chrono::steady_clock::now();
+    const uint64_t ticks0 = ticks();
+
+    // 計測自体のコスト（空の区間）
+    Histogram timer;
+    for (int i = 0; i < 1000000; i++) {
+        const uint64_t start = ticks();
+        timer.record(ticks() - start);
+    }
+
+    struct Row {
+        Scenario scenario;
+        int threads;
+        Histogram hist;
+    };
+    std::vector<Row> rows;
+    for (int s = 0; s < SCENARIO_COUNT; s++) {
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            rows.push_back({static_cast<Scenario>(s), threads,
+                            run(static_cast<Scenario>(s), threads, calls)});
+        }
+    }
+
+    const double ns_per_tick =
+        std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - steady0)
+            .count() /
+        static_cast<double>(ticks() - ticks0);
+
+    fprintf(stderr, "# LOG_ASYNC=%d LOG_DEFERRED=%d, %d calls/thread, ns\n",
+            LOG_ASYNC, LOG_DEFERRED, calls);
+    fprintf(stderr, "%-10s %7s %9s %9s %9s %11s\n", "scenario", "threads",
+            "p50", "p99", "p99.9", "max");
+    auto print = [&](const char* name, int threads, const Histogram& h) {
+        fprintf(stderr, "%-10s %7d %9.0f %9.0f %9.0f %11.0f\n", name, threads,
+                h.percentile(0.5) * ns_per_tick,
+                h.percentile(0.99) * ns_per_tick,
+                h.percentile(0.999) * ns_per_tick, h.max() * ns_per_tick);
+    };
+    print("timer", 1, timer);
+    for (const Row& row : rows) {
+        print(SCENARIO_NAMES[row.scenario], row.threads, row.hist);
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+// bench_suite.cpp
+// 回帰検出用の総合ベンチマーク
+// LOG_INFO（引数なし・あり・色タグ付き）と無効レベルのLOG_DEBUGについて、
+// フォーマッタ（ConsoleFmt / PlainFmt）× writer（ConsoleWriter /
+// BufferedWriter / null）× 生産者スレッド数（1, 2, 4, ... 最大）の組み合わせで
+// 1回あたりの時間とスループットを測り、CSVで出力する。
+// 各組み合わせはR回測って最良値を採る。標準出力へ書くwriterの出力は
+// /dev/nullへ捨てる（結果は元の標準出力か-oのファイルへ）。
+//
+//   g++ -std=c++14 -O2 -pthread bench/bench_suite.cpp -o bench_suite
+//   ./bench_suite [-t 最大スレッド数] [-n 1スレッドあたりの回数] [-R 回数]
+//                 [-o 結果.csv] [-b 基準.csv] [-r 許容比]
+//
+//   -b  基準のCSV（以前の結果）とns_per_callを比べ、許容比（既定1.15）を
+//       超えて遅くなった組み合わせがあれば標準エラーへ出して終了コード1
+//
+// 列: case,formatter,writer,threads,calls,ns_per_call,mlogs_per_sec
+//   ns_per_call    1スレッドから見た1回あたりの時間（出力待ちを除く）
+//   mlogs_per_sec  全スレッド合計の処理量（最後のflushまで含む）
+// LOG_ASYNC / LOG_DEFERREDなどは-Dで切り替え、先頭の#行に記録される。
+
+#include "../logger.hpp"
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace logger;
+
+namespace {
+
+/**
+ * @brief フォーマットまで行い、出力は捨てるwriter
+ * @details スレッド毎の作業領域へ書かせるので、フォーマッタと
+ * Logger本体のコストだけが残る
+ */
+class NullWriter : public Writers::IWriter {
+   public:
+    void write(const LogEntry& entry) override { (void)entry; }
+    void flush() override {}
+    char* reserve(size_t size) override {
+        (void)size;
+        return Memory::thread_staging();
+    }
+};
+
+enum Case { INFO_NOARGS, INFO_ARGS, INFO_TAGS, DEBUG_OFF, CASE_COUNT };
+const char* const CASE_NAMES[] = {"info_noargs", "info_args", "info_tags",
+                                  "debug_off"};
+
+enum Fmt { CONSOLE_FMT, PLAIN_FMT, FMT_COUNT };
+const char* const FMT_NAMES[] = {"console", "plain"};
+
+enum Sink { CONSOLE_WRITER, BUFFERED_WRITER, NULL_WRITER, SINK_COUNT };
+const char* const SINK_NAMES[] = {"console", "buffered", "null"};
+
+/**
+ * @brief 1スレッド分の呼び出し
+ * @return ループにかかった時間[ns]
+ */
+double produce(Logger& log, Case c, int tid, long calls) {
+    static const char* const WORKERS[] = {"alpha", "beta", "gamma", "delta"};
+    auto start = std::chrono::steady_clock::now();
+    switch (c) {
+        case INFO_NOARGS:
+            for (long i = 0; i < calls; i++) {
+                LOG_TO(log, LogLevel::INFO_, "request served");
+            }
+            break;
+        case INFO_ARGS:
+            for (long i = 0; i < calls; i++) {
+                LOG_TO(log, LogLevel::INFO_,
+                       "request %ld served in %d us by %s", i, tid * 7 + 3,
+                       WORKERS[i & 3]);
+            }
+            break;
+        case INFO_TAGS:
+            for (long i = 0; i < calls; i++) {
+                LOG_TO(log, LogLevel::INFO_,
+                       "request g|%ld| served in y|%d| us by b|%s|", i,
+                       tid * 7 + 3, WORKERS[i & 3]);
+            }
+            break;
+        default:
+            for (long i = 0; i < calls; i++) {
+                LOG_TO(log, LogLevel::DEBUG_, "cache %ld lookup for %s", i,
+                       WORKERS[i & 3]);
+            }
+            break;
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+struct Result {
+    double ns_per_call;
+    double mlogs_per_sec;
+};
+
+/**
+ * @brief 1つの組み合わせを1回測る
+ */
+Result measure(Case c, Fmt f, Sink s, int threads, long calls) {
+    std::unique_ptr<Formatters::FormatterBase> formatter;
+    if (f == CONSOLE_FMT) {
+        formatter.reset(new Formatters::ConsoleFmt(true));
+    } else {
+        formatter.reset(new Formatters::PlainFmt());
+    }
+    std::unique_ptr<Writers::IWriter> writer;
+    if (s == CONSOLE_WRITER) {
+        writer.reset(new Writers::ConsoleWriter());
+    } else if (s == BUFFERED_WRITER) {
+        writer.reset(new Writers::BufferedWriter());
+    } else {
+        writer.reset(new NullWriter());
+    }
+    Logger log{std::move(formatter), std::move(writer)};
+    log.set_level(LogLevel::INFO_);
+#if LOG_ASYNC
+    log.start_async();
+#endif
+
+    // 全スレッドを揃えてから始める
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<double> elapsed(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            elapsed[t] = produce(log, c, t, calls);
+        });
+    }
+    while (ready.load() != threads) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& th : pool) {
+        th.join();
+    }
+    log.flush();
+    auto end = std::chrono::steady_clock::now();
+
+    double sum = 0;
+    for (double ns : elapsed) {
+        sum += ns;
+    }
+    const double total = static_cast<double>(calls) * threads;
+    const double wall =
+        std::chrono::duration<double, std::nano>(end - start).count();
+    return {sum / total, total / wall * 1e3};
+}
+
+/**
+ * @brief 基準CSVを読む（キーは先頭4列）
+ */
+std::map<std::string, double> load_baseline(const char* path) {
+    std::map<std::string, double> baseline;
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        exit(2);
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        char name[32], fmt[32], sink[32];
+        int threads;
+        long calls;
+        double ns;
+        if (line[0] == '#' ||
+            sscanf(line, "%31[^,],%31[^,],%31[^,],%d,%ld,%lf", name, fmt, sink,
+                   &threads, &calls, &ns) != 6) {
+            continue;  // コメント・見出し行
+        }
+        baseline[std::string(name) + "," + fmt + "," + sink + "," +
+                 std::to_string(threads)] = ns;
+    }
+    fclose(fp);
+    return baseline;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int max_threads = static_cast<int>(std::thread::hardware_concurrency());
+    long calls = 200000;
+    int repeat = 3;
+    const char* out_path = nullptr;
+    const char* baseline_path = nullptr;
+    double tolerance = 1.15;
+    bool usage = argc % 2 == 0;  // オプションは全て値を取る
+    for (int i = 1; !usage && i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-t") == 0) {
+            max_threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            calls = atol(argv[i + 1]);
+        } else if (strcmp(argv[i], "-R") == 0) {
+            repeat = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            out_path = argv[i + 1];
+        } else if (strcmp(argv[i], "-b") == 0) {
+            baseline_path = argv[i + 1];
+        } else if (strcmp(argv[i], "-r") == 0) {
+            tolerance = atof(argv[i + 1]);
+        } else {
+            usage = true;
+        }
+    }
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    if (usage || calls < 1 || repeat < 1 || tolerance <= 0) {
+        fprintf(stderr,
+                "usage: %s [-t threads] [-n calls] [-R repeat] [-o out.csv] "
+                "[-b baseline.csv] [-r ratio]\n",
+                argv[0]);
+        return 2;
+    }
+    std::map<std::string, double> baseline;
+    if (baseline_path != nullptr) {
+        baseline = load_baseline(baseline_path);
+    }
+
+    // 結果は元の標準出力へ、ログ出力は/dev/nullへ
+    FILE* results = out_path != nullptr ? fopen(out_path, "w")
+                                        : fdopen(dup(STDOUT_FILENO), "w");
+    if (results == nullptr || freopen("/dev/null", "w", stdout) == nullptr) {
+        fprintf(stderr, "cannot set up output\n");
+        return 2;
+    }
+
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    Time::now();  // 較正を計測から外す
+    fprintf(results,
+            "# LOG_ASYNC=%d LOG_DEFERRED=%d LOG_TSC=%d COL_CHECK=%d "
+            "hardware_concurrency=%u repeat=%d\n",
+            LOG_ASYNC, LOG_DEFERRED, LOG_TSC, COL_CHECK,
+            std::thread::hardware_concurrency(), repeat);
+    fprintf(results,
+            "case,formatter,writer,threads,calls,ns_per_call,mlogs_per_sec\n");
+
+    int regressions = 0;
+    for (int c = 0; c < CASE_COUNT; c++) {
+        // 無効レベルは出力しないので組み合わせは1つ、回数は多めに
+        const bool off = c == DEBUG_OFF;
+        const long n = off ? calls * 50 : calls;
+        for (int f = 0; f < (off ? 1 : FMT_COUNT); f++) {
+            for (int s = off ? NULL_WRITER : 0; s < SINK_COUNT; s++) {
+                // 無効レベルではフォーマッタもwriterも使われない
+                const char* fmt_name = off ? "none" : FMT_NAMES[f];
+                const char* sink_name = off ? "none" : SINK_NAMES[s];
+                for (int threads : thread_counts) {
+                    Result best = {1e300, 0};
+                    for (int r = 0; r < repeat; r++) {
+                        Result res =
+                            measure(static_cast<Case>(c), static_cast<Fmt>(f),
+                                    static_cast<Sink>(s), threads, n);
+                        best.ns_per_call =
+                            std::min(best.ns_per_call, res.ns_per_call);
+                        best.mlogs_per_sec =
+                            std::max(best.mlogs_per_sec, res.mlogs_per_sec);
+                    }
+                    fprintf(results, "%s,%s,%s,%d,%ld,%.2f,%.3f\n",
+                            CASE_NAMES[c], fmt_name, sink_name, threads, n,
+                            best.ns_per_call, best.mlogs_per_sec);
+                    fflush(results);
+
+                    std::string key = std::string(CASE_NAMES[c]) + "," +
+                                      fmt_name + "," + sink_name + "," +
+                                      std::to_string(threads);
+                    auto it = baseline.find(key);
+                    if (it != baseline.end() &&
+                        best.ns_per_call > it->second * tolerance) {
+                        fprintf(stderr, "regression: %s %.2f -> %.2f ns\n",
+                                key.c_str(), it->second, best.ns_per_call);
+                        regressions++;
+                    }
+                }
+            }
+        }
+    }
+    fclose(results);
+    return regressions != 0 ? 1 : 0;
+}
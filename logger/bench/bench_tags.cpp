@@ -0,0 +1,210 @@
+// bench_tags.cpp
+// 色タグ走査のマイクロベンチマーク
+// TagScanner（1パス・SIMD）と、従来の1文字ずつのループ
+// （strlen + 検証 / 解析 / 除去をそれぞれ走査）を比較する。
+// LOG_*経由の正しさはtests/test_tags.cppで確認する。
+//
+//   g++ -std=c++14 -O2 -march=native bench/bench_tags.cpp -o bench_tags
+//   ./bench_tags
+
+#include "../logger.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace legacy {
+// TagScanner導入前の実装（比較用）
+
+static bool validate(const char* input) {
+    bool pipe_odd = false;
+    int input_len = strlen(input);
+    if (input_len > 0 && input[0] == '|') {
+        return false;
+    }
+    for (int i = 0; i < input_len; i++) {
+        if (input[i] != '|') {
+            continue;
+        }
+        if (!pipe_odd) {
+            if (i + 1 < input_len && input[i + 1] == '|') {
+                i++;
+                continue;
+            }
+            if (logger::ColorMap::ansi_code(input[i - 1]) == nullptr) {
+                return false;
+            }
+            pipe_odd = true;
+        } else {
+            pipe_odd = false;
+        }
+    }
+    return !pipe_odd;
+}
+
+static void parse(const char* input, char* output, int max_len) {
+    bool pipe_odd = false;
+    int out_pos = 0;
+    int input_len = strlen(input);
+    for (int i = 0; i < input_len && out_pos < max_len - 1; i++) {
+        if (input[i] != '|') {
+            output[out_pos++] = input[i];
+            continue;
+        }
+        if (!pipe_odd) {
+            if (i + 1 < input_len && input[i + 1] == '|') {
+                output[out_pos++] = '|';
+                i++;
+                continue;
+            }
+            const char* code = logger::ColorMap::ansi_code(input[i - 1]);
+            if (code != nullptr) {
+                out_pos--;
+                int code_len = strlen(code);
+                if (out_pos + code_len < max_len - 1) {
+                    strcpy(output + out_pos, code);
+                    out_pos += code_len;
+                }
+            }
+            pipe_odd = true;
+        } else {
+            int reset_len = strlen(logger::ColorMap::RESET);
+            if (out_pos + reset_len < max_len - 1) {
+                strcpy(output + out_pos, logger::ColorMap::RESET);
+                out_pos += reset_len;
+            }
+            pipe_odd = false;
+        }
+    }
+    output[out_pos] = '\0';
+}
+
+static void strip(const char* input, char* output, int max_len) {
+    bool pipe_odd = false;
+    int out_pos = 0;
+    int input_len = strlen(input);
+    for (int i = 0; i < input_len && out_pos < max_len - 1; i++) {
+        if (input[i] != '|') {
+            output[out_pos++] = input[i];
+            continue;
+        }
+        if (!pipe_odd) {
+            if (i + 1 < input_len && input[i + 1] == '|') {
+                output[out_pos++] = '|';
+                i++;
+                continue;
+            }
+            if (out_pos > 0) {
+                out_pos--;
+            }
+            pipe_odd = true;
+        } else {
+            pipe_odd = false;
+        }
+    }
+    output[out_pos] = '\0';
+}
+}  // namespace legacy
+
+// main.cppのcolorString相当（1文字ごとに色タグ）
+static std::string color_string(const std::string& str) {
+    static const char tags[] = "rgybpalsmotnfzwk";
+    std::string out;
+    for (char c : str) {
+        out += tags[rand() % 16];
+        out += '|';
+        out += c;
+        out += '|';
+    }
+    return out;
+}
+
+template <typename F>
+static double measure_ns(const std::vector<std::string>& inputs, F&& fn) {
+    const int rounds = 20000;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const auto& in : inputs) {
+            fn(in.c_str());
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / (rounds * inputs.size());
+}
+
+static volatile char sink;
+
+static void run_case(const char* name, const std::vector<std::string>& inputs) {
+    char out[LOG_FMT_SIZE];
+    using logger::Utils::TagScanner;
+
+    // 結果が一致することを先に確認
+    for (const auto& in : inputs) {
+        char expect[LOG_FMT_SIZE];
+        legacy::parse(in.c_str(), expect, sizeof(expect));
+        TagScanner::scan(in.c_str(), out, sizeof(out), TagScanner::ANSI);
+        if (strcmp(expect, out) != 0) {
+            printf("MISMATCH(parse): %s\n", in.c_str());
+        }
+        legacy::strip(in.c_str(), expect, sizeof(expect));
+        TagScanner::scan(in.c_str(), out, sizeof(out), TagScanner::STRIP);
+        if (strcmp(expect, out) != 0) {
+            printf("MISMATCH(strip): %s\n", in.c_str());
+        }
+        if (legacy::validate(in.c_str()) !=
+            TagScanner::scan(in.c_str(), nullptr, 0, TagScanner::VALIDATE)) {
+            printf("MISMATCH(validate): %s\n", in.c_str());
+        }
+    }
+
+    double old_ansi = measure_ns(inputs, [&](const char* in) {
+        if (legacy::validate(in)) legacy::parse(in, out, sizeof(out));
+        sink = out[0];
+    });
+    double new_ansi = measure_ns(inputs, [&](const char* in) {
+        TagScanner::scan(in, out, sizeof(out), TagScanner::ANSI);
+        sink = out[0];
+    });
+    double old_strip = measure_ns(inputs, [&](const char* in) {
+        if (legacy::validate(in)) legacy::strip(in, out, sizeof(out));
+        sink = out[0];
+    });
+    double new_strip = measure_ns(inputs, [&](const char* in) {
+        TagScanner::scan(in, out, sizeof(out), TagScanner::STRIP);
+        sink = out[0];
+    });
+
+    printf("%-12s validate+parse %8.1f ns -> scan(ANSI)  %8.1f ns (x%.2f)\n",
+           name, old_ansi, new_ansi, old_ansi / new_ansi);
+    printf("%-12s validate+strip %8.1f ns -> scan(STRIP) %8.1f ns (x%.2f)\n",
+           name, old_strip, new_strip, old_strip / new_strip);
+}
+
+int main() {
+    srand(1);
+#if !defined(LOG_NO_SIMD) && defined(__AVX2__)
+    printf("scanner: AVX2\n");
+#elif !defined(LOG_NO_SIMD) && defined(__SSE2__)
+    printf("scanner: SSE2\n");
+#else
+    printf("scanner: scalar\n");
+#endif
+    std::vector<std::string> tag_heavy;
+    std::vector<std::string> sparse;
+    std::vector<std::string> plain;
+    for (int i = 0; i < 16; i++) {
+        tag_heavy.push_back(color_string("Hello, world! testing colorfull"));
+        sparse.push_back(
+            "sensor loop tick " + std::to_string(i) +
+            ": g|nominal| temperature within limits, r|check| the motor "
+            "driver current if it exceeds b|threshold| again");
+        plain.push_back("plain message without any color tags, iteration " +
+                        std::to_string(i) + " of the control loop");
+    }
+
+    run_case("tag-heavy", tag_heavy);
+    run_case("sparse", sparse);
+    run_case("plain", plain);
+    return 0;
+}
@@ -0,0 +1,76 @@
+// bench_time.cpp
+// 時刻の取得と描画のコスト計測
+// Time::now（較正済みTSC）とsystem_clock、キャッシュした日時の描画
+// （Time::append）と毎回strftime + snprintfで描く方法を比べる。
+// 最後にTime::nowとsystem_clockのずれを表示する。
+//
+//   g++ -std=c++14 -O2 -pthread bench/bench_time.cpp -o bench_time
+//   ./bench_time
+
+#include "../logger.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace logger;
+
+namespace {
+
+const int CALLS = 10000000;
+
+/**
+ * @brief fnをCALLS回呼んだ1回あたりの時間を表示
+ */
+template <typename Fn>
+void run(const char* name, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    printf("%-26s %6.1f ns/call\n", name,
+           std::chrono::duration<double, std::nano>(end - start).count() /
+               CALLS);
+}
+
+int64_t wall_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+int main() {
+    Time::now();  // 較正
+    printf("clock source: %s\n",
+           Time::Clock::instance().uses_tsc() ? "TSC" : "steady_clock");
+
+    volatile uint64_t sink = 0;
+    run("Time::now", [&](int) { sink = sink + Time::now(); });
+    run("system_clock::now", [&](int) { sink = sink + wall_ns(); });
+
+    char buf[64];
+    run("now + append (cached)", [&](int) {
+        Utils::LineBuilder line(buf, sizeof(buf));
+        Time::append(line, Time::now(), Time::Precision::MICROS);
+        sink = sink + line.size();
+    });
+    run("now + strftime + snprintf", [&](int) {
+        int64_t ns = wall_ns();
+        time_t sec = static_cast<time_t>(ns / 1000000000);
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        size_t len = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+        len += snprintf(buf + len, sizeof(buf) - len, ".%06d ",
+                        static_cast<int>(ns % 1000000000 / 1000));
+        sink = sink + len;
+    });
+
+    for (int i = 0; i < 3; i++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        int64_t drift = static_cast<int64_t>(Time::now()) - wall_ns();
+        printf("drift after %ds: %+lld ns\n", i + 1,
+               static_cast<long long>(drift));
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// bench_uring.cpp
+// io_uring出力とpwrite出力の比較
+// UringWriter（io_uringで非同期に書く）と、同じwriterをpwriteで同期的に
+// 書く設定、FileWriter（writev）で、1行あたりの時間と呼び出し1回の
+// 最大時間（ブロックの書き出しで止まった時間）を計測する。
+//
+//   g++ -std=c++14 -O2 -pthread bench/bench_uring.cpp -o bench_uring
+//   ./bench_uring [出力先ディレクトリ]
+
+#include "../logger.hpp"
+#include <chrono>
+#include <string>
+
+using namespace logger;
+
+namespace {
+
+const int LINES = 2000000;
+
+/**
+ * @brief LINES行を書いてflushするまでの時間を計測して表示
+ */
+void run(const char* name, const std::string& path,
+         Writers::IWriter* writer) {
+    {
+        Logger log{std::unique_ptr<Formatters::FormatterBase>(
+                       new Formatters::PlainFmt()),
+                   std::unique_ptr<Writers::IWriter>(writer)};
+        double worst = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto prev = start;
+        for (int i = 0; i < LINES; i++) {
+            LOG_TO(log, LogLevel::INFO_,
+                   "request %d served in %d us by worker %s", i, i % 977,
+                   "io-3");
+            auto now = std::chrono::steady_clock::now();
+            double ns =
+                std::chrono::duration<double, std::nano>(now - prev).count();
+            if (ns > worst) {
+                worst = ns;
+            }
+            prev = now;
+        }
+        log.flush();
+        auto end = std::chrono::steady_clock::now();
+        double ns =
+            std::chrono::duration<double, std::nano>(end - start).count();
+
+        FILE* file = fopen(path.c_str(), "rb");
+        fseek(file, 0, SEEK_END);
+        double mb = ftell(file) / 1e6;
+        fclose(file);
+        printf("%-18s %8.1f ns/log %8.1f MB/s  max %8.1f us\n", name,
+               ns / LINES, mb / (ns / 1e9), worst / 1e3);
+    }
+    remove(path.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : ".";
+    std::string path = dir + "/bench_uring.log";
+    remove(path.c_str());
+
+    Writers::UringWriter* uring = new Writers::UringWriter(path.c_str());
+    if (!uring->uses_uring()) {
+        printf("io_uring unavailable: UringWriter falls back to pwrite\n");
+    }
+    run("UringWriter", path, uring);
+    run("pwrite (fallback)", path,
+        new Writers::UringWriter(path.c_str(), false));
+    run("FileWriter", path, new Writers::FileWriter(path.c_str()));
+    return 0;
+}
@@ -0,0 +1,205 @@
+// stress_threads.cpp
+// 複数スレッドからの同時ログ出力の検証とスケーリング計測
+// 1. 検証: 全スレッドの行が欠けず、途切れず、スレッド毎の順序通りに
+//    出力されることを確認する（1行でも壊れていれば終了コード1）
+// 2. 差し替え: 別スレッドで出力ペアを付け外ししながら1.と同じ検証をする
+// 3. 計測: スレッド数を変えて1行あたりの時間と総スループットを出す
+//
+//   g++ -std=c++14 -O2 -pthread bench/stress_threads.cpp -o stress_threads
+//   ./stress_threads [最大スレッド数]
+
+#include "../logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace logger;
+
+namespace {
+
+const int MAX_THREADS = 64;
+const int VERIFY_LINES = 2000;  // 検証時の1スレッドあたりの行数
+const int BENCH_LINES = 200000;  // 計測時の1スレッドあたりの行数
+
+/**
+ * @brief 出力された行を検査するwriter
+ * @details 行の形式: "[INFO] stress_threads.cpp:NN : T<tid> #<seq> <payload>"
+ * payloadはtid毎の文字がseq%64個並ぶ
+ */
+class CheckWriter : public Writers::BaseBufferedWriter {
+   public:
+    long lines = 0;
+    long errors = 0;
+    int last_seq[MAX_THREADS];
+
+    CheckWriter() {
+        for (int& seq : last_seq) {
+            seq = -1;
+        }
+    }
+
+    ~CheckWriter() override { flush(); }
+
+   protected:
+    void output(const Chunk* chunks, int n) override {
+        for (int i = 0; i < n; i++) {
+            check_chunk(chunks[i].data, chunks[i].len);
+        }
+    }
+
+   private:
+    void check_chunk(const char* data, size_t len) {
+        const char* end = data + len;
+        while (data < end) {
+            const char* eol = static_cast<const char*>(
+                memchr(data, '\n', static_cast<size_t>(end - data)));
+            if (eol == nullptr || eol == data || eol[-1] != '\r') {
+                errors++;  // 改行の無い断片
+                return;
+            }
+            check_line(std::string(data, eol - 1));
+            data = eol + 1;
+        }
+    }
+
+    void check_line(const std::string& line) {
+        lines++;
+        size_t body = line.find(" : T");
+        int tid = -1;
+        int seq = -1;
+        int consumed = 0;
+        if (body == std::string::npos ||
+            sscanf(line.c_str() + body, " : T%d #%d %n", &tid, &seq,
+                   &consumed) != 2 ||
+            tid < 0 || tid >= MAX_THREADS) {
+            report("malformed", line);
+            return;
+        }
+        std::string payload = line.substr(body + consumed);
+        if (payload != std::string(seq % 64, static_cast<char>('a' + tid % 26))) {
+            report("torn payload", line);
+        }
+        if (seq != last_seq[tid] + 1) {
+            report("out of order", line);
+        }
+        last_seq[tid] = seq;
+    }
+
+    void report(const char* what, const std::string& line) {
+        if (errors++ < 10) {
+            printf("  %s: %s\n", what, line.c_str());
+        }
+    }
+};
+
+void worker(Logger* log, int tid, int count) {
+    char payload[64];
+    memset(payload, 'a' + tid % 26, sizeof(payload));
+    for (int i = 0; i < count; i++) {
+        LOG_TO(*log, LogLevel::INFO_, "T%d #%d %.*s", tid, i, i % 64,
+               payload);
+    }
+}
+
+/**
+ * @brief threads個のスレッドでcount行ずつ出力
+ * @return 経過時間[ns]
+ */
+double run(Logger& log, int threads, int count) {
+    std::vector<std::thread> pool;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back(worker, &log, t, count);
+    }
+    for (auto& th : pool) {
+        th.join();
+    }
+    log.flush();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+/**
+ * @brief 全スレッドの行が揃ったか確認して結果を表示
+ * @return 揃っていればtrue
+ */
+bool verify(const char* label, CheckWriter* checker, int threads) {
+    long expected = static_cast<long>(threads) * VERIFY_LINES;
+    for (int t = 0; t < threads; t++) {
+        if (checker->last_seq[t] != VERIFY_LINES - 1) {
+            checker->errors++;
+        }
+    }
+    printf("%s: %d threads, %ld/%ld lines, %ld errors\n", label, threads,
+           checker->lines, expected, checker->errors);
+    return checker->errors == 0 && checker->lines == expected;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 16;
+    if (max_threads < 1 || max_threads > MAX_THREADS) {
+        max_threads = 16;
+    }
+
+    // 1. 検証
+    {
+        CheckWriter* checker = new CheckWriter();
+        Logger log{std::unique_ptr<Formatters::FormatterBase>(
+                       new Formatters::PlainFmt()),
+                   std::unique_ptr<Writers::IWriter>(checker)};
+        run(log, max_threads, VERIFY_LINES);
+        if (!verify("verify", checker, max_threads)) {
+            return 1;
+        }
+    }
+
+    // 2. 出力ペアを付け外ししながら検証（残るペアの行は欠けない）
+    {
+        CheckWriter* checker = new CheckWriter();
+        Logger log{std::unique_ptr<Formatters::FormatterBase>(
+                       new Formatters::PlainFmt()),
+                   std::unique_ptr<Writers::IWriter>(checker)};
+        std::atomic<bool> done{false};
+        long swaps = 0;
+        std::thread control([&] {
+            while (!done.load(std::memory_order_acquire)) {
+                log.add_pair(std::unique_ptr<Formatters::FormatterBase>(
+                                 new Formatters::ConsoleFmt(true)),
+                             std::unique_ptr<Writers::IWriter>(
+                                 new Writers::BaseBufferedWriter()));
+                log.remove_pair(1);
+                swaps++;
+            }
+        });
+        run(log, max_threads, VERIFY_LINES);
+        done.store(true, std::memory_order_release);
+        control.join();
+        printf("swap: %ld pair swaps during the run\n", swaps);
+        if (!verify("swap", checker, max_threads)) {
+            return 1;
+        }
+    }
+
+    // 3. 計測（出力は捨てる）
+    printf("%8s %12s %14s %8s\n", "threads", "ns/log", "Mlines/s", "scale");
+    double base_rate = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        Logger log{std::unique_ptr<Formatters::FormatterBase>(
+                       new Formatters::PlainFmt()),
+                   std::unique_ptr<Writers::IWriter>(
+                       new Writers::BaseBufferedWriter())};
+        double ns = run(log, threads, BENCH_LINES);
+        double total = static_cast<double>(threads) * BENCH_LINES;
+        double rate = total / ns * 1e3;
+        if (threads == 1) {
+            base_rate = rate;
+        }
+        printf("%8d %12.1f %14.2f %8.2f\n", threads, ns * threads / total,
+               rate, rate / base_rate);
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file log_async.hpp
+ * @brief 非同期ログ用のロックフリーキュー
+ * @details 呼び出しスレッドはレコードを積むだけで、フォーマットと出力は
+ * バックエンドスレッドが行う
+ * @author ren255
+ */
+
+#ifndef LOG_ASYNC_HPP
+#define LOG_ASYNC_HPP
+
+#include <atomic>   // ロックフリー同期（std::atomic）
+#include <chrono>   // バックエンドの待機時間
+#include <cstdint>  // intptr_t
+#include <thread>   // バックエンドスレッド（std::thread）
+
+namespace logger {
+/**
+ * @brief 非同期出力を提供する名前空間
+ */
+namespace Async {
+
+/**
+ * @brief キューに積まれるログレコード
+ */
+struct Record {
+    LogLevel level;              ///< ログレベル
+    const char* filename;        ///< ソースファイル名（__FILE__）
+    int line;                    ///< 行番号
+    timestamp_t timestamp;       ///< 呼び出し時刻
+#if LOG_DEFERRED
+    FormatInfo fmt;              ///< フォーマット文字列（未整形）
+    uint16_t payload_len;        ///< payloadの使用バイト数
+    char payload[LOG_MSG_SIZE];  ///< Deferred::encodeで詰めた引数
+#else
+    FormatInfo fmt;                    ///< フォーマット情報（フラグのみ使用）
+    int variants;                      ///< 整形済みの版（1: ANSI, 2: 除去）
+    char message[LOG_MSG_SIZE];        ///< vsnprintf済み（ANSI版）
+    char plain_message[LOG_MSG_SIZE];  ///< vsnprintf済み（タグ除去版）
+#endif
+};
+
+/**
+ * @brief 有界ロックフリーMPSCキュー
+ * @details スロット毎のシーケンス番号で所有権を受け渡す(Vyukov方式)。
+ * 生産者はCAS1回で枠を確保し、そのスロットへ直接書き込んでから公開する。
+ * 消費者は1スレッドのみ。満杯時は待たずにnullptrを返す。
+ * @tparam Capacity スロット数（2の冪）
+ */
+template <size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of 2");
+
+   private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq;
+        Record record;
+    };
+
+    Slot slots[Capacity];
+    alignas(64) std::atomic<size_t> enqueue_pos{0};  // 確保済みチケット数
+    alignas(64) std::atomic<size_t> dequeue_pos{0};  // 処理済みレコード数
+
+   public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * @brief 書き込み用スロットを確保（生産者）
+     * @param ticket 確保したチケット番号（publishに渡す）
+     * @return 書き込み先レコード、満杯ならnullptr
+     */
+    Record* try_claim(size_t& ticket) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (Capacity - 1)];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    ticket = pos;
+                    return &slot.record;
+                }
+            } else if (diff < 0) {
+                return nullptr;  // 満杯
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief 書き込み完了したスロットを消費者へ公開（生産者）
+     * @param ticket try_claimで得たチケット番号
+     */
+    void publish(size_t ticket) {
+        slots[ticket & (Capacity - 1)].seq.store(ticket + 1,
+                                                 std::memory_order_release);
+    }
+
+    /**
+     * @brief 先頭レコードを取得（消費者）
+     * @return 公開済みの先頭レコード、無ければnullptr
+     */
+    Record* peek() {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & (Capacity - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;
+        }
+        return &slot.record;
+    }
+
+    /**
+     * @brief 先頭レコードを解放してスロットを生産者へ返す（消費者）
+     */
+    void pop() {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        slots[pos & (Capacity - 1)].seq.store(pos + Capacity,
+                                              std::memory_order_release);
+        dequeue_pos.store(pos + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief これまでに確保されたチケット数
+     */
+    size_t claimed() const {
+        return enqueue_pos.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief これまでに処理されたレコード数
+     */
+    size_t consumed() const {
+        return dequeue_pos.load(std::memory_order_acquire);
+    }
+};
+
+}  // namespace Async
+}  // namespace logger
+
+#endif  // LOG_ASYNC_HPP
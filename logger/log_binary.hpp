@@ -0,0 +1,564 @@
+/**
+ * @file log_binary.hpp
+ * @brief バイナリ形式のログファイル
+ * @details 書き込み側ではテキストを組み立てず、呼び出し箇所ID・時刻・
+ * 引数の生バイト（LOG_DEFERREDのペイロード）だけを書く。フォーマット文字列
+ * は呼び出し箇所毎に1度だけ辞書レコードとして同じファイルへ書き、
+ * テキストへの変換はデコーダ（tools/log_decode.cpp）で行う
+ * @author ren255
+ */
+
+#ifndef LOG_BINARY_HPP
+#define LOG_BINARY_HPP
+
+#include <atomic>  // 呼び出し箇所の登録
+#include <cstdint>
+#include <string>  // デコード用の辞書
+#include <vector>
+#include "log_deferred.hpp"  // ペイロードの形式とデコード
+
+namespace logger {
+/**
+ * @brief バイナリ形式のレコードを提供する名前空間
+ * @details ファイルはレコードの並び。先頭1バイトの上位4bitが種別、
+ * 下位4bitがLogLevel。整数は全てリトルエンディアン、長さとIDはLEB128
+ *
+ * - SESSION: "CLOGBIN1" + 開始時刻(u64 ns)。ファイルを開く毎に書き、
+ *   以降のレコードのIDはこの辞書を指す
+ * - FORMAT:  種別 | ID | フラグ(u8) | 行 | ファイル名 | ANSI版 | タグ除去版
+ *   （文字列は長さ + 本体。タグ除去版がANSI版と同じなら長さ0）
+ * - DATA:    種別 | ID | 時刻(u64 ns) | 長さ | 引数
+ * - TEXT:    種別 | 時刻(u64 ns) | フラグ(u8) | 行 | ファイル名 | メッセージ
+ *   （辞書に載せられない呼び出しの整形済みメッセージ）
+ *
+ * 引数は型タグ(ArgType) + 値で、整数はzigzag/LEB128、文字列は長さ + 本体
+ */
+namespace Binary {
+
+/**
+ * @brief レコードの種別（先頭バイトの上位4bit）
+ */
+enum Kind : uint8_t {
+    DATA = 1,     ///< 呼び出し箇所ID + 時刻 + 引数
+    FORMAT = 2,   ///< 辞書: 呼び出し箇所のファイル名・行・フォーマット
+    TEXT = 3,     ///< 整形済みのメッセージ
+    SESSION = 4,  ///< SESSION_MAGICの先頭'C'(0x43)の上位4bit
+};
+
+constexpr char SESSION_MAGIC[8] = {'C', 'L', 'O', 'G', 'B', 'I', 'N', '1'};
+constexpr size_t SESSION_SIZE = 16;  ///< SESSIONレコードのバイト数
+
+/**
+ * @brief FORMAT/TEXTのフラグ
+ */
+enum Flag : uint8_t {
+    RUNTIME_TAGS = 1,  ///< FormatInfo::runtime_tags（解析時に色タグを検証する）
+    PLAIN_SAME = 4,    ///< タグ除去版がANSI版と同じ
+};
+
+inline char* put_varint(char* p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<char>(value);
+    return p;
+}
+
+/**
+ * @brief LEB128を読む
+ * @return 読んだ後の位置、途切れていればnullptr
+ */
+inline const char* get_varint(const char* p, const char* end,
+                              uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+inline char* put_u64(char* p, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        *p++ = static_cast<char>(value >> (i * 8));
+    }
+    return p;
+}
+
+inline uint64_t get_u64(const char* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (i * 8);
+    }
+    return value;
+}
+
+/**
+ * @brief 長さ + 本体を書く（limitを超える分は切り詰める）
+ */
+inline char* put_string(char* p, const char* limit, const char* str,
+                        size_t len) {
+    size_t room = limit - p > 3 ? static_cast<size_t>(limit - p) - 3 : 0;
+    if (len > room) {
+        len = room;
+    }
+    p = put_varint(p, len);
+    memcpy(p, str, len);
+    return p + len;
+}
+
+inline char* put_session(char* p, uint64_t start_ns) {
+    memcpy(p, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    return put_u64(p + sizeof(SESSION_MAGIC), start_ns);
+}
+
+/**
+ * @brief Deferred::encodeのペイロードを詰めた形式へ変換
+ * @details 入り切らない引数以降は捨てる（ArgEncoderと同じ扱い）
+ * @return 書いたバイト数
+ */
+inline size_t pack_args(const char* payload, size_t len, char* out,
+                        size_t cap) {
+    using Deferred::ArgType;
+    const char* p = payload;
+    const char* end = payload + len;
+    size_t pos = 0;
+    char value[16];
+    while (p < end) {
+        ArgType type = static_cast<ArgType>(*p);
+        char* v = value;
+        const char* str = nullptr;
+        size_t str_len = 0;
+        if (type == ArgType::STRING) {
+            uint16_t len16;
+            if (end - p < 3) break;
+            memcpy(&len16, p + 1, sizeof(len16));
+            if (static_cast<size_t>(end - p) < 3u + len16 + 1u) break;
+            str = p + 3;
+            str_len = len16;
+            v = put_varint(v, str_len);
+            p += 3 + len16 + 1;
+        } else {
+            if (end - p < 9) break;
+            uint64_t raw;
+            memcpy(&raw, p + 1, sizeof(raw));
+            if (type == ArgType::DOUBLE) {
+                v = put_u64(v, raw);
+            } else if (type == ArgType::INT) {
+                int64_t s = static_cast<int64_t>(raw);
+                v = put_varint(v, (raw << 1) ^ static_cast<uint64_t>(s >> 63));
+            } else {
+                v = put_varint(v, raw);
+            }
+            p += 9;
+        }
+        size_t head = static_cast<size_t>(v - value);
+        if (pos + 1 + head + str_len > cap) {
+            break;
+        }
+        out[pos++] = static_cast<char>(type);
+        memcpy(out + pos, value, head);
+        pos += head;
+        if (str != nullptr) {
+            memcpy(out + pos, str, str_len);
+            pos += str_len;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief 詰めた形式をDeferred::formatで読めるペイロードへ戻す
+ * @return 書いたバイト数
+ */
+inline size_t unpack_args(const char* data, size_t len, char* out,
+                          size_t cap) {
+    using Deferred::ArgType;
+    const char* p = data;
+    const char* end = data + len;
+    size_t pos = 0;
+    while (p < end) {
+        ArgType type = static_cast<ArgType>(*p++);
+        uint64_t raw = 0;
+        if (type == ArgType::STRING) {
+            uint64_t str_len;
+            p = get_varint(p, end, str_len);
+            if (p == nullptr || str_len > static_cast<size_t>(end - p) ||
+                str_len > UINT16_MAX || pos + 4 + str_len > cap) {
+                break;
+            }
+            uint16_t len16 = static_cast<uint16_t>(str_len);
+            out[pos++] = static_cast<char>(type);
+            memcpy(out + pos, &len16, sizeof(len16));
+            pos += sizeof(len16);
+            memcpy(out + pos, p, str_len);
+            pos += str_len;
+            out[pos++] = '\0';
+            p += str_len;
+            continue;
+        }
+        if (type == ArgType::DOUBLE) {
+            if (end - p < 8) break;
+            raw = get_u64(p);
+            p += 8;
+        } else {
+            p = get_varint(p, end, raw);
+            if (p == nullptr) break;
+            if (type == ArgType::INT) {
+                raw = (raw >> 1) ^ (0 - (raw & 1));
+            }
+        }
+        if (pos + 9 > cap) {
+            break;
+        }
+        out[pos++] = static_cast<char>(type);
+        memcpy(out + pos, &raw, sizeof(raw));
+        pos += sizeof(raw);
+    }
+    return pos;
+}
+
+/**
+ * @brief 呼び出し箇所 -> IDの表
+ * @details CallSiteのアドレスで引くロックフリーのオープンアドレス表。
+ * IDはスロットの番号で、最初に登録したスレッドが辞書レコードを書く
+ */
+class SiteTable {
+   private:
+    std::atomic<const CallSite*> sites[LOG_BINARY_SITES];
+
+   public:
+    SiteTable() {
+        for (auto& site : sites) {
+            site.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 呼び出し箇所のIDを引く（無ければ登録）
+     * @param fresh この呼び出しで登録した場合true
+     * @return ID、表が満杯なら-1
+     */
+    int find(const CallSite* site, bool& fresh) {
+        const size_t mask = LOG_BINARY_SITES - 1;
+        size_t index = static_cast<size_t>(
+            (reinterpret_cast<uintptr_t>(site) >> 3) * 0x9E3779B97F4A7C15ull >>
+            32);
+        for (size_t probe = 0; probe < LOG_BINARY_SITES; probe++) {
+            size_t id = (index + probe) & mask;
+            const CallSite* current = sites[id].load(std::memory_order_acquire);
+            if (current == nullptr &&
+                sites[id].compare_exchange_strong(current, site,
+                                                  std::memory_order_acq_rel)) {
+                fresh = true;
+                return static_cast<int>(id);
+            }
+            if (current == site) {
+                fresh = false;
+                return static_cast<int>(id);
+            }
+        }
+        return -1;
+    }
+};
+
+/**
+ * @brief 読み取ったレコード（文字列はファイル内を指す）
+ */
+struct Record {
+    Kind kind;
+    LogLevel level;
+    uint32_t id;    ///< DATA/FORMAT
+    uint64_t time;  ///< DATA/TEXT/SESSION
+    uint8_t flags;  ///< FORMAT/TEXT
+    int line;       ///< FORMAT/TEXT
+    const char* str[3];  ///< FORMAT: ファイル名, ANSI版, タグ除去版 / TEXT: ファイル名, メッセージ
+    size_t str_len[3];
+    const char* data;  ///< DATA: 詰めた引数
+    size_t data_len;
+};
+
+/**
+ * @brief 1レコードを読む
+ * @return レコードのバイト数、途切れているか不正なら0
+ */
+inline size_t parse(const char* begin, const char* end, Record& rec) {
+    if (begin >= end) {
+        return 0;
+    }
+    const char* p = begin;
+    uint8_t head = static_cast<uint8_t>(*p);
+    rec.kind = static_cast<Kind>(head >> 4);
+    rec.level = static_cast<LogLevel>(head & 0x0f);
+    uint64_t value;
+    if (rec.kind == SESSION) {
+        if (end - p < static_cast<ptrdiff_t>(SESSION_SIZE) ||
+            memcmp(p, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+            return 0;
+        }
+        rec.time = get_u64(p + sizeof(SESSION_MAGIC));
+        return SESSION_SIZE;
+    }
+    if ((head & 0x0f) > static_cast<uint8_t>(LogLevel::ERROR_)) {
+        return 0;
+    }
+    p++;
+    int strings = 0;
+    if (rec.kind == DATA || rec.kind == FORMAT) {
+        if ((p = get_varint(p, end, value)) == nullptr) return 0;
+        rec.id = static_cast<uint32_t>(value);
+    }
+    if (rec.kind == DATA || rec.kind == TEXT) {
+        if (end - p < 8) return 0;
+        rec.time = get_u64(p);
+        p += 8;
+    }
+    switch (rec.kind) {
+        case DATA:
+            if ((p = get_varint(p, end, value)) == nullptr ||
+                value > static_cast<uint64_t>(end - p)) {
+                return 0;
+            }
+            rec.data = p;
+            rec.data_len = static_cast<size_t>(value);
+            return static_cast<size_t>(p + value - begin);
+        case FORMAT:
+            strings = 3;
+            break;
+        case TEXT:
+            strings = 2;
+            break;
+        default:
+            return 0;
+    }
+    if (p >= end) return 0;
+    rec.flags = static_cast<uint8_t>(*p++);
+    if ((p = get_varint(p, end, value)) == nullptr) return 0;
+    rec.line = static_cast<int>(value);
+    for (int i = 0; i < strings; i++) {
+        if ((p = get_varint(p, end, value)) == nullptr ||
+            value > static_cast<uint64_t>(end - p)) {
+            return 0;
+        }
+        rec.str[i] = p;
+        rec.str_len[i] = static_cast<size_t>(value);
+        p += value;
+    }
+    return static_cast<size_t>(p - begin);
+}
+
+/**
+ * @brief 1セッション分の辞書（デコード用）
+ */
+struct Dictionary {
+    struct Entry {
+        bool valid = false;
+        int line = 0;
+        uint8_t flags = 0;
+        std::string file;
+        std::string ansi;
+        std::string plain;
+    };
+    std::vector<Entry> entries;
+
+    void add(const Record& rec) {
+        if (rec.id >= entries.size()) {
+            entries.resize(rec.id + 1);
+        }
+        Entry& entry = entries[rec.id];
+        entry.valid = true;
+        entry.line = rec.line;
+        entry.flags = rec.flags;
+        entry.file.assign(rec.str[0], rec.str_len[0]);
+        entry.ansi.assign(rec.str[1], rec.str_len[1]);
+        if (rec.flags & PLAIN_SAME) {
+            entry.plain = entry.ansi;
+        } else {
+            entry.plain.assign(rec.str[2], rec.str_len[2]);
+        }
+    }
+
+    const Entry* find(uint32_t id) const {
+        return id < entries.size() && entries[id].valid ? &entries[id]
+                                                        : nullptr;
+    }
+};
+
+/**
+ * @brief DATA/TEXTレコードを既存のフォーマッタで1行に描画
+ * @details 書き込み時と同じLogEntryを組み立ててformatterへ渡すので、
+ * 色タグの変換・除去と時刻の描画もConsoleFmt/PlainFmtがそのまま行う
+ * @param out 出力先（LOG_FMT_SIZE以上）
+ * @return 出力文字数、描画できない（辞書に無い）場合0
+ */
+inline size_t render(const Record& rec, const Dictionary& dictionary,
+                     Formatters::FormatterBase& formatter, char* out,
+                     size_t size) {
+    char message[LOG_MSG_SIZE];
+    char file[LOG_MSG_SIZE];
+    LogEntry entry = {};
+    entry.level = rec.level;
+    entry.timestamp = rec.time;
+    entry.message = message;
+    entry.plain_message = message;
+    entry.formatedMsg = out;
+
+    if (rec.kind == DATA) {
+        const Dictionary::Entry* format = dictionary.find(rec.id);
+        if (format == nullptr) {
+            return 0;
+        }
+        char payload[LOG_MSG_SIZE * 2];
+        size_t len = unpack_args(rec.data, rec.data_len, payload,
+                                 sizeof(payload));
+        const std::string& fmt =
+            formatter.uses_color() ? format->ansi : format->plain;
+        Deferred::format(fmt.c_str(), payload, len, message, sizeof(message));
+        entry.filename = format->file.c_str();
+        entry.line = format->line;
+        entry.runtime_tags = (format->flags & RUNTIME_TAGS) != 0;
+    } else if (rec.kind == TEXT) {
+        size_t len = rec.str_len[1] < sizeof(message) - 1
+                         ? rec.str_len[1]
+                         : sizeof(message) - 1;
+        memcpy(message, rec.str[1], len);
+        message[len] = '\0';
+        len = rec.str_len[0] < sizeof(file) - 1 ? rec.str_len[0]
+                                                : sizeof(file) - 1;
+        memcpy(file, rec.str[0], len);
+        file[len] = '\0';
+        entry.filename = file;
+        entry.line = rec.line;
+        entry.runtime_tags = (rec.flags & RUNTIME_TAGS) != 0;
+    } else {
+        return 0;
+    }
+    return formatter.format(entry, out, size);
+}
+
+}  // namespace Binary
+
+namespace Formatters {
+
+/**
+ * @brief バイナリ形式のフォーマッタ
+ * @details テキストを組み立てず、呼び出し箇所IDと時刻と引数のバイトを
+ * 書く（LOG_DEFERREDが必要。無効ならTEXTレコードになる）。呼び出し箇所を
+ * 初めて書くときだけ、その前に辞書レコードを置く。改行を付けない
+ * BinaryFileWriterと組み合わせて使う
+ */
+class BinaryFmt : public FormatterBase {
+   private:
+    Binary::SiteTable sites;
+
+    /**
+     * @brief 辞書レコードを書く（limitを超える文字列は切り詰める）
+     */
+    static char* put_format(char* p, const char* limit, int id,
+                            const LogEntry& entry, const FormatInfo& fmt) {
+        const CallSite* site = fmt.site;
+        bool same = fmt.ansi == fmt.plain;
+        *p++ = static_cast<char>(Binary::FORMAT << 4 |
+                                 static_cast<uint8_t>(entry.level));
+        p = Binary::put_varint(p, static_cast<uint64_t>(id));
+        *p++ = static_cast<char>((fmt.runtime_tags ? Binary::RUNTIME_TAGS : 0) |
+                                 (same ? Binary::PLAIN_SAME : 0));
+        p = Binary::put_varint(p, static_cast<uint64_t>(site->line));
+        p = Binary::put_string(p, limit, site->basename,
+                               strlen(site->basename));
+        // 残りをANSI版とタグ除去版で分ける
+        const char* half = p + (limit - p) / 2;
+        p = Binary::put_string(p, same ? limit : half, fmt.ansi,
+                               strlen(fmt.ansi));
+        return same ? Binary::put_varint(p, 0)
+                    : Binary::put_string(p, limit, fmt.plain,
+                                         strlen(fmt.plain));
+    }
+
+   public:
+    bool uses_message() const override { return false; }
+
+    size_t format(const LogEntry& entry, char* out, size_t size) override {
+        const uint64_t time = entry.timestamp;
+        const uint8_t level = static_cast<uint8_t>(entry.level);
+        char* p = out;
+        const FormatInfo* fmt = entry.format;
+        if (entry.payload != nullptr && fmt != nullptr &&
+            fmt->site != nullptr) {
+            bool fresh;
+            int id = sites.find(fmt->site, fresh);
+            if (id >= 0) {
+                char args[LOG_FMT_SIZE];
+                size_t len = Binary::pack_args(entry.payload,
+                                               entry.payload_len, args,
+                                               size / 2);
+                if (fresh) {
+                    // DATAレコード（最大 1 + 2 + 8 + 2 + len）の分を残す
+                    p = put_format(p, out + size - (16 + len), id, entry,
+                                   *fmt);
+                }
+                *p++ = static_cast<char>(Binary::DATA << 4 | level);
+                p = Binary::put_varint(p, static_cast<uint64_t>(id));
+                p = Binary::put_u64(p, time);
+                p = Binary::put_varint(p, len);
+                memcpy(p, args, len);
+                return static_cast<size_t>(p + len - out);
+            }
+        }
+
+        // 辞書に載せられない: タグ除去版のメッセージをそのまま書く
+        const char* file = Utils::StringUtils::extract_filename(entry.filename);
+        *p++ = static_cast<char>(Binary::TEXT << 4 | level);
+        p = Binary::put_u64(p, time);
+        *p++ = static_cast<char>(entry.runtime_tags ? Binary::RUNTIME_TAGS
+                                                    : 0);
+        p = Binary::put_varint(p, static_cast<uint64_t>(entry.line));
+        p = Binary::put_string(p, out + size / 2, file, strlen(file));
+        p = Binary::put_string(p, out + size, entry.plain_message,
+                               strlen(entry.plain_message));
+        return static_cast<size_t>(p - out);
+    }
+};
+
+}  // namespace Formatters
+
+#if LOG_FILE
+namespace Writers {
+
+/**
+ * @brief バイナリ形式のファイル出力クラス
+ * @details FileWriterと同じくブロックにまとめてwritevで書くが、レコードに
+ * 改行を付けない。開く毎にSESSIONレコードを書き、辞書はそこから始まる
+ * （BinaryFmtと1対1で使う。ローテーションは辞書が分かれるため非対応）
+ */
+class BinaryFileWriter : public FileWriter {
+   public:
+    explicit BinaryFileWriter(const char* path,
+                              SyncPolicy sync_policy = SyncPolicy::none())
+        : FileWriter(path, sync_policy) {
+        char header[Binary::SESSION_SIZE];
+        Binary::put_session(header, Time::now());
+        append_raw(header, sizeof(header));
+    }
+
+    /**
+     * @brief reserveは常に成功するので呼ばれない（formatedMsgは'\0'を含みうる）
+     */
+    void write(const LogEntry& entry) override { (void)entry; }
+
+    void commit(const LogEntry& entry, size_t len) override {
+        append_raw(Memory::thread_staging(), len);
+        after_record(entry.level);
+    }
+};
+
+}  // namespace Writers
+#endif
+
+}  // namespace logger
+
+#endif  // LOG_BINARY_HPP
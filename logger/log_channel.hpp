@@ -0,0 +1,151 @@
+/**
+ * @file log_channel.hpp
+ * @brief 名前付きチャネル
+ * @details "motor"や"net"などのチャネル毎にレベルと出力先のペアを持つ。
+ * チャネルは番号で表の1行を指し、LOG_CHの判定はレベル表（連続した
+ * 1バイトの配列）からrelaxedで1回読むだけ
+ * @author ren255
+ */
+
+#ifndef LOG_CHANNEL_HPP
+#define LOG_CHANNEL_HPP
+
+#include <atomic>   // ロックフリー同期（std::atomic）
+#include <cstdint>  // uint8_t, uint32_t
+#include <cstring>  // strcmp
+#include <mutex>    // 登録時の排他（std::mutex）
+
+namespace logger {
+/**
+ * @brief 名前付きチャネルを提供する名前空間
+ */
+namespace Channels {
+
+/**
+ * @brief チャネル表
+ * @details 0番は"default"（登録前・表が満杯のときに使う）。
+ * constexprで初期化できるので、参照しても初期化ガードを伴わない
+ */
+struct Table {
+    std::atomic<uint8_t> levels[LOG_MAX_CHANNELS];     // 最小レベル（LOG_CHが読む）
+    std::atomic<uint32_t> excluded[LOG_MAX_CHANNELS];  // 出力しないペアのビット
+    const char* names[LOG_MAX_CHANNELS];
+    std::atomic<int> count;  // 登録済みの数
+    std::mutex mutex;        // 登録の排他
+
+    constexpr Table()
+        : levels{{static_cast<uint8_t>(LogLevel::INFO_)}},
+          excluded{},
+          names{"default"},
+          count{1},
+          mutex{} {}
+};
+
+inline Table& table() {
+    static Table instance;
+    return instance;
+}
+
+/**
+ * @brief 名前の番号を引く（無ければ登録）
+ * @details 新しいチャネルのレベルはINFO、出力先は全ペア。
+ * nameは登録後も生存するもの（文字列リテラルなど）であること
+ * @return 番号、表が満杯なら0（default）
+ */
+inline int register_channel(const char* name) {
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    const int count = t.count.load(std::memory_order_relaxed);
+    for (int id = 0; id < count; id++) {
+        if (strcmp(t.names[id], name) == 0) {
+            return id;
+        }
+    }
+    if (count == static_cast<int>(LOG_MAX_CHANNELS)) {
+        return 0;
+    }
+    t.names[count] = name;
+    t.levels[count].store(static_cast<uint8_t>(LogLevel::INFO_),
+                          std::memory_order_relaxed);
+    t.excluded[count].store(0, std::memory_order_relaxed);
+    t.count.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+/**
+ * @brief 呼び出し箇所から参照するチャネルのハンドル
+ * @details LOG_CHANNELで名前空間スコープにstaticで定義する。
+ * 番号は静的初期化時に1度だけ引く
+ */
+struct Channel {
+    int id;
+
+    explicit Channel(const char* name) : id(register_channel(name)) {}
+};
+
+/**
+ * @brief チャネルでlevelが出力対象か（LOG_CHが呼ぶ）
+ */
+inline bool enabled(const Channel& channel, LogLevel level) {
+    return static_cast<uint8_t>(level) >=
+           table().levels[channel.id].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief チャネルの出力先ペアのビット（i番目のペアへ出すならビットi）
+ * @param channel チャネル（nullptrなら全ペア）
+ */
+inline uint32_t pairs(const Channel* channel) {
+    if (channel == nullptr) {
+        return ~0u;
+    }
+    return ~table().excluded[channel->id].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief チャネルの最小レベルを設定（未登録なら登録）
+ * @return 表が満杯で設定できなければfalse
+ */
+inline bool set_level(const char* name, LogLevel level) {
+    const int id = register_channel(name);
+    if (id == 0 && strcmp(name, "default") != 0) {
+        return false;
+    }
+    table().levels[id].store(static_cast<uint8_t>(level),
+                             std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief チャネルの出力先ペアを設定（未登録なら登録）
+ * @param mask i番目のLoggerPairへ出すならビットi（既定は全ビット）
+ * @return 表が満杯で設定できなければfalse
+ */
+inline bool set_pairs(const char* name, uint32_t mask) {
+    const int id = register_channel(name);
+    if (id == 0 && strcmp(name, "default") != 0) {
+        return false;
+    }
+    table().excluded[id].store(~mask, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief チャネルの最小レベルを取得（未登録ならINFO）
+ */
+inline LogLevel get_level(const char* name) {
+    Table& t = table();
+    const int count = t.count.load(std::memory_order_acquire);
+    for (int id = 0; id < count; id++) {
+        if (strcmp(t.names[id], name) == 0) {
+            return static_cast<LogLevel>(
+                t.levels[id].load(std::memory_order_relaxed));
+        }
+    }
+    return LogLevel::INFO_;
+}
+
+}  // namespace Channels
+}  // namespace logger
+
+#endif  // LOG_CHANNEL_HPP
@@ -7,10 +7,12 @@ namespace logger {
 struct LoggerPair {
     std::unique_ptr<Formatters::FormatterBase> formatter;
     std::unique_ptr<Writers::IWriter> writer;
+    LogLevel min_level;  ///< このペアへ出す最小レベル（PairSetを作る時に読む）
 
     LoggerPair(std::unique_ptr<Formatters::FormatterBase> fmt,
-               std::unique_ptr<Writers::IWriter> wrt)
-        : formatter(std::move(fmt)), writer(std::move(wrt)) {
+               std::unique_ptr<Writers::IWriter> wrt,
+               LogLevel level = LogLevel::DEBUG_)
+        : formatter(std::move(fmt)), writer(std::move(wrt)), min_level(level) {
         if (!formatter || !writer) {
             while (1) {
                 printf("[ERROR_] formatterとwriteを設定して下さい\r\n");
@@ -19,53 +21,529 @@ struct LoggerPair {
     }
 };
 
+/**
+ * @brief 出力ペアの集合（公開後は変更しない）
+ * @details 差し替えは新しい集合を作って公開する。引き続き使うペアは
+ * 新旧の集合で共有する。各ペアの最小レベルから、レベル毎に
+ * 受けるペアのビットと使うメッセージの版をここで求めておく
+ */
+struct PairSet {
+    static constexpr uint8_t WANT_ANSI = 1;   ///< ANSI版メッセージ
+    static constexpr uint8_t WANT_PLAIN = 2;  ///< タグ除去版メッセージ
+    static constexpr uint8_t WANT_RAW = 4;    ///< 整形前のペイロード（バイナリ）
+    static constexpr uint8_t WANT_ALL = 7;    ///< WANT_*の和
+    /// Loggerのレベル以上（Logger::wantedでのみ立てる、集合は持たない）
+    static constexpr uint8_t LEVEL_ON = 8;
+    static constexpr int LEVELS = 4;          ///< LogLevelの数
+
+    std::vector<std::shared_ptr<LoggerPair>> pairs;
+    std::vector<LogLevel> levels;  ///< 各ペアの最小レベル（作った時点の値）
+    /// レベル毎の受けるペアのビット（32番目以降のペアはlevelsで判定）
+    uint32_t level_pairs[LEVELS] = {};
+    /// レベル毎の使う版（WANT_*の和、0ならそのレベルを受けるペアが無い）
+    uint8_t wanted[LEVELS] = {};
+
+    explicit PairSet(std::vector<std::shared_ptr<LoggerPair>> list)
+        : pairs(std::move(list)) {
+        levels.reserve(pairs.size());
+        for (size_t i = 0; i < pairs.size(); i++) {
+            const LoggerPair& pair = *pairs[i];
+            levels.push_back(pair.min_level);
+            const uint8_t want = !pair.formatter->uses_message() ? WANT_RAW
+                                 : pair.formatter->uses_color()  ? WANT_ANSI
+                                                                 : WANT_PLAIN;
+            for (int level = static_cast<int>(pair.min_level); level < LEVELS;
+                 level++) {
+                wanted[level] |= want;
+                if (i < 32) {
+                    level_pairs[level] |= 1u << i;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief wantedを1語にまとめる（レベルLの版はビット8L〜8L+7）
+     */
+    uint32_t packed_wanted() const {
+        uint32_t packed = 0;
+        for (int level = 0; level < LEVELS; level++) {
+            packed |= static_cast<uint32_t>(wanted[level]) << (8 * level);
+        }
+        return packed;
+    }
+};
+
 /**
  * @brief メインLoggerクラス
- * @details ログ出力の統括管理を行うオーケストレータ（複数出力対応）
+ * @details ログ出力の統括管理を行うオーケストレータ（複数出力対応）。
+ * log_outputは複数スレッドから同時に呼べる（整形はスレッド毎のバッファで
+ * 行い、共有のwriterへはロックフリーで渡す）。
+ * レベルと出力ペアは実行中に変更でき、ログを出すスレッドはロックされない
  */
 class Logger {
    private:
-    LogLevel current_level;
-    std::vector<LoggerPair> output_pairs;
+    std::atomic<LogLevel> current_level{LogLevel::INFO_};
+    std::atomic<PairSet*> output_pairs{nullptr};  // 読むのはRcu::ReadGuardの中
+    // レベル毎の整形する版（PairSet::packed_wanted、差し替え中は新旧の和）と、
+    // current_level以上のレベルのPairSet::LEVEL_ON
+    std::atomic<uint32_t> wanted{0};
+    std::mutex config_mutex;         // 出力ペアの差し替えとレベル変更の排他
+
+    /**
+     * @brief 版の和にcurrent_levelのLEVEL_ONを重ねて公開
+     * @details config_mutexを持って（または公開前に）呼ぶ
+     */
+    void store_wanted(uint32_t packed) {
+        const int lowest = static_cast<int>(
+            current_level.load(std::memory_order_relaxed));
+        for (int level = lowest; level < PairSet::LEVELS; level++) {
+            packed |= static_cast<uint32_t>(PairSet::LEVEL_ON) << (8 * level);
+        }
+        wanted.store(packed, std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief 整形が必要なメッセージの版
+     * @details ペイロードを使うペアも、呼び出し箇所が無い（辞書に載せられ
+     * ない）場合と遅延フォーマットでない場合はタグ除去版を使う
+     * そのレベルを受けないペアの分は整形しない
+     * @return 0: 不要, 1: ANSI版のみ, 2: タグ除去版のみ, 3: 両方
+     */
+    int needed_variants(LogLevel level, const FormatInfo& fmt) const {
+        const uint32_t want = wanted.load(std::memory_order_seq_cst) >>
+                              (8 * static_cast<int>(level));
+        const bool want_ansi = (want & PairSet::WANT_ANSI) != 0;
+        const bool want_plain = (want & PairSet::WANT_PLAIN) != 0;
+        const bool want_raw = (want & PairSet::WANT_RAW) != 0;
+        bool plain = want_plain ||
+                     (want_raw && (!LOG_DEFERRED || fmt.site == nullptr));
+        if (!plain) {
+            return want_ansi ? 1 : 0;
+        }
+        if (fmt.ansi == fmt.plain) {
+            return 1;
+        }
+        return want_ansi ? 3 : 2;
+    }
+
+    /**
+     * @brief 必要な版だけメッセージをvsnprintf
+     * @param ansi_out ANSI版の出力先（LOG_MSG_SIZE）
+     * @param plain_out タグ除去版の出力先（LOG_MSG_SIZE）
+     * @return 整形した版（needed_variantsの値）
+     */
+    int format_message(LogLevel level, const FormatInfo& fmt, va_list args,
+                       char* ansi_out, char* plain_out) {
+        int variants = needed_variants(level, fmt);
+        if (variants & 1) {
+            va_list copy;
+            va_copy(copy, args);
+            vsnprintf(ansi_out, LOG_MSG_SIZE, fmt.ansi, copy);
+            va_end(copy);
+        }
+        if (variants & 2) {
+            vsnprintf(plain_out, LOG_MSG_SIZE, fmt.plain, args);
+        }
+        return variants;
+    }
+
+#if LOG_DEFERRED
+    /**
+     * @brief 必要な版だけペイロードからメッセージを復元
+     * @return 復元した版（needed_variantsの値）
+     */
+    int decode_message(LogLevel level, const FormatInfo& fmt,
+                       const char* payload, size_t len, char* ansi_out,
+                       char* plain_out) {
+        int variants = needed_variants(level, fmt);
+        if (variants & 1) {
+            Deferred::format(fmt.ansi, payload, len, ansi_out, LOG_MSG_SIZE);
+        }
+        if (variants & 2) {
+            Deferred::format(fmt.plain, payload, len, plain_out, LOG_MSG_SIZE);
+        }
+        return variants;
+    }
+#endif
+
+    /**
+     * @brief LineBuilderへ書き込む関数を呼ぶ
+     */
+    template <typename Producer>
+    static auto produce(Producer& producer, Utils::LineBuilder& out, int)
+        -> decltype(producer(out), void()) {
+        producer(out);
+    }
+
+    /**
+     * @brief 文字列を返す関数を呼んで追加
+     */
+    template <typename Producer>
+    static void produce(Producer& producer, Utils::LineBuilder& out, long) {
+        append_text(out, producer(), 0);
+    }
+
+    template <typename Text>
+    static auto append_text(Utils::LineBuilder& out, const Text& text, int)
+        -> decltype(text.data(), text.size(), void()) {
+        out.append(text.data(), text.size());
+    }
+
+    static void append_text(Utils::LineBuilder& out, const char* text, long) {
+        out.append(text);
+    }
+
+    /**
+     * @brief 整形済みの版を選んでlog_internalへ渡す
+     * @param time 呼び出し時刻
+     * @param payload 引数の生バイト（遅延フォーマットのみ、無ければnullptr）
+     */
+    void log_variants(LogLevel level, const char* file, int line,
+                      timestamp_t time, const FormatInfo& fmt, int variants,
+                      const char* ansi_msg, const char* plain_msg,
+                      const char* payload = nullptr, size_t payload_len = 0) {
+        const char* message = variants == 0  ? ""
+                              : (variants & 1) ? ansi_msg
+                                               : plain_msg;
+        const char* plain = (variants & 2) ? plain_msg : message;
+        log_internal(level, file, line, time, message, plain,
+                     fmt.runtime_tags, fmt.site,
+                     payload != nullptr ? &fmt : nullptr, payload, payload_len,
+                     Channels::pairs(fmt.channel));
+    }
+
+#if LOG_DEDUP
+    std::unique_ptr<Dedup::Tracker, Memory::AlignedDeleter> dedup;
+
+    /**
+     * @brief "last message repeated N times"を出力
+     */
+    void emit_summary(const Dedup::Summary& summary) {
+        char msg[LOG_MSG_SIZE];
+        snprintf(msg, sizeof(msg), "last message repeated %u times over %.3f s",
+                 summary.count,
+                 static_cast<double>(summary.last - summary.first) / 1e9);
+        log_internal(summary.site->level, summary.site->basename,
+                     summary.site->line, summary.last, msg, msg, false,
+                     summary.site, nullptr, nullptr, 0,
+                     Channels::pairs(summary.channel));
+    }
+
+    /**
+     * @brief 直前と同じレコードなら捨てる
+     * @details 呼び出し箇所が無い（マクロ経由でない）レコードは集約しない。
+     * 続きが途切れた・時間が経った場合は、先に集約行を出力する
+     * @param data 引数を表すバイト列（ペイロードか整形済みのメッセージ）
+     * @return 捨てた場合true
+     */
+    bool drop_repeat(const FormatInfo& fmt, timestamp_t time, const char* data,
+                     size_t len) {
+        if (fmt.site == nullptr) {
+            return false;
+        }
+        Dedup::Summary summary;
+        bool repeated = dedup->repeated(fmt.site, fmt.channel,
+                                        Dedup::hash(data, len), time, summary);
+        if (summary.count != 0) {
+            emit_summary(summary);
+        }
+        return repeated;
+    }
+
+    /**
+     * @brief 整形済みのメッセージで判定する版（遅延フォーマットでない場合）
+     */
+    bool drop_repeat(const FormatInfo& fmt, timestamp_t time, int variants,
+                     const char* ansi_msg, const char* plain_msg) {
+        const char* message = variants == 0  ? ""
+                              : (variants & 1) ? ansi_msg
+                                               : plain_msg;
+        return drop_repeat(fmt, time, message, strlen(message));
+    }
+#endif
+
+#if LOG_ASYNC
+    using Queue = Async::MpscQueue<LOG_QUEUE_SIZE>;
+    std::unique_ptr<Queue, Memory::AlignedDeleter> queue;
+    std::thread backend;
+    std::atomic<bool> async_running{false};  // 生産者が読む（読み取り区間の中）
+    std::atomic<bool> backend_stop{false};   // バックエンドが読む
+    std::atomic<size_t> flush_request{0};  // この番号まで処理後にflush
+    std::atomic<size_t> flush_done{0};     // flush済みの番号
+    std::atomic<size_t> dropped{0};        // キュー満杯で捨てた数
+
+    /**
+     * @brief キューに積まれたレコードを処理（バックエンドスレッド）
+     * @return 1件以上処理した場合true
+     */
+    bool drain_queue() {
+        bool processed = false;
+        while (Async::Record* rec = queue->peek()) {
+            processed = true;
+            Rcu::ReadGuard guard;  // 整形した版と出力ペアの組を揃える
+#if LOG_DEDUP
+#if LOG_DEFERRED
+            const bool repeated = drop_repeat(rec->fmt, rec->timestamp,
+                                              rec->payload, rec->payload_len);
+#else
+            const bool repeated =
+                drop_repeat(rec->fmt, rec->timestamp, rec->variants,
+                            rec->message, rec->plain_message);
+#endif
+            if (repeated) {
+                queue->pop();
+                continue;
+            }
+#endif
+#if LOG_DEFERRED
+            char msg[LOG_MSG_SIZE];
+            char plain[LOG_MSG_SIZE];
+            int variants = decode_message(rec->level, rec->fmt, rec->payload,
+                                          rec->payload_len, msg, plain);
+            log_variants(rec->level, rec->filename, rec->line, rec->timestamp,
+                         rec->fmt, variants, msg, plain, rec->payload,
+                         rec->payload_len);
+#else
+            log_variants(rec->level, rec->filename, rec->line, rec->timestamp,
+                         rec->fmt, rec->variants, rec->message,
+                         rec->plain_message);
+#endif
+            queue->pop();
+        }
+        return processed;
+    }
+
+    /**
+     * @brief flush要求が処理済み位置に追いついていればwriterをflush
+     */
+    void serve_flush_request() {
+        size_t request = flush_request.load(std::memory_order_acquire);
+        if (request > flush_done.load(std::memory_order_relaxed) &&
+            queue->consumed() >= request) {
+            flush_writers();
+            flush_done.store(request, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief 破棄数の変化をWARNとして出力
+     */
+    void report_dropped(size_t& reported) {
+        size_t now = dropped.load(std::memory_order_relaxed);
+        if (now != reported) {
+            char msg[LOG_MSG_SIZE];
+            snprintf(msg, sizeof(msg), "async queue full: %u records dropped",
+                     (unsigned)(now - reported));
+            log_internal(LogLevel::WARN_, __FILE__, __LINE__, Time::now(), msg,
+                         msg, false, nullptr);
+            reported = now;
+        }
+    }
+
+    /**
+     * @brief バックエンドスレッド本体
+     * @details 空の間は数回yieldしてから短くsleepする。
+     * 停止時は確保済みの全レコードを処理してからflushして終了
+     */
+    void backend_loop() {
+        size_t reported = 0;
+        int idle = 0;
+        while (!backend_stop.load(std::memory_order_acquire)) {
+            if (drain_queue()) {
+                idle = 0;
+            } else if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            report_dropped(reported);
+            serve_flush_request();
+        }
+
+        // 停止: 生産者は全て積み終えている（stop_async）。確保済みだが
+        // 未公開のレコードも公開を待って処理する
+        while (queue->consumed() < queue->claimed()) {
+            if (!drain_queue()) {
+                std::this_thread::yield();
+            }
+        }
+        report_dropped(reported);
+        flush_writers();
+        flush_done.store(queue->consumed(), std::memory_order_release);
+    }
+
+    /**
+     * @brief キューのスロットを確保してヘッダを書く（生産者）
+     * @return 確保したレコード、満杯ならnullptr（破棄数を加算）
+     */
+    Async::Record* claim_record(size_t& ticket, LogLevel level,
+                                const char* file, int line) {
+        Async::Record* rec = queue->try_claim(ticket);
+        if (rec == nullptr) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        rec->level = level;
+        rec->filename = file;
+        rec->line = line;
+        rec->timestamp = Time::now();
+        return rec;
+    }
+
+#if !LOG_DEFERRED
+    /**
+     * @brief レコードをキューに積む（生産者）
+     */
+    void enqueue(LogLevel level, const char* file, int line,
+                 const FormatInfo& fmt, va_list args) {
+        size_t ticket;
+        Async::Record* rec = claim_record(ticket, level, file, line);
+        if (rec == nullptr) {
+            return;
+        }
+        rec->fmt = fmt;
+        rec->variants = format_message(level, fmt, args, rec->message,
+                                       rec->plain_message);
+        queue->publish(ticket);
+    }
+#endif
+#endif
+
+    /**
+     * @brief 全出力先のwriterをflush
+     * @details 集約中の繰り返しがあれば先に集約行を出力する
+     */
+    void flush_writers() {
+#if LOG_DEDUP
+        dedup->drain(
+            [this](const Dedup::Summary& summary) { emit_summary(summary); });
+#endif
+        Rcu::ReadGuard guard;
+        for (auto& pair : output_pairs.load(std::memory_order_seq_cst)->pairs) {
+            pair->writer->flush();
+        }
+    }
 
     /**
      * @brief LogEntryを作成
+     * @param site 呼び出し箇所（無ければnullptr）
+     * @param buffer フォーマット出力先（スレッド専用バッファ）
      */
     LogEntry create_log_entry(LogLevel level, const char* file, int line,
-                              const char* message) {
+                              timestamp_t time, const char* message,
+                              const char* plain, bool runtime_tags,
+                              const CallSite* site, char* buffer,
+                              const FormatInfo* format, const char* payload,
+                              size_t payload_len) {
         LogEntry entry;
         entry.level = level;
         entry.filename = file;
         entry.line = line;
+        entry.timestamp = time;
         entry.message = message;
-        entry.formatedMsg = (char*)malloc(LOG_FMT_SIZE);
+        entry.plain_message = plain;
+        entry.runtime_tags = runtime_tags;
+        entry.formatedMsg = buffer;
+        entry.site = site;
+        entry.format = format;
+        entry.payload = payload;
+        entry.payload_len = static_cast<uint16_t>(payload_len);
         return entry;
     }
 
     /**
-     * @brief 内部ログ出力処理（全出力先に対して実行）
+     * @brief エントリを全出力ペアでフォーマット・出力
+     * @details 領域を予約できるwriterにはフォーマッタが直接書き込む。
+     * できないwriterにはformatedMsgへフォーマットしてからwriteする
+     * レベルを受けないペアは、集合が持つレベル毎のビットで除く
+     * @param pairs 出力するペアのビット（32番目以降のペアには常に出す）
      */
-    void log_internal(LogLevel level, const char* file, int line,
-                      const char* message) {
-        if (level < current_level) {
+    void dispatch(const LogEntry& entry, uint32_t pairs) {
+        Rcu::ReadGuard guard;
+        const PairSet& set = *output_pairs.load(std::memory_order_seq_cst);
+        const uint32_t mask =
+            pairs & set.level_pairs[static_cast<int>(entry.level)];
+        const size_t count = set.pairs.size();
+        if (mask == 0 && count <= 32) {
             return;
         }
-        LogEntry entry;
-
-        // 実行時バリデーション
-        if (!Utils::ValidationUtils::validate_color_tags_runtime(message)) {
-            entry = create_log_entry(LogLevel::ERROR_, file, line,
-                                     "Invalid color tags");
-        } else {
-            entry = create_log_entry(level, file, line, message);
+        for (size_t i = 0; i < count; i++) {
+            if (i < 32 ? (mask >> i & 1) == 0 : entry.level < set.levels[i]) {
+                continue;
+            }
+            LoggerPair& pair = *set.pairs[i];
+            char* out = pair.writer->reserve(LOG_FMT_SIZE);
+            if (out != nullptr) {
+                pair.writer->commit(
+                    entry, pair.formatter->format(entry, out, LOG_FMT_SIZE));
+            } else {
+                pair.formatter->format(entry, entry.formatedMsg, LOG_FMT_SIZE);
+                pair.writer->write(entry);
+            }
         }
+    }
 
-        for (auto& pair : output_pairs) {
-            pair.formatter->format(entry);
-            pair.writer->write(entry);
-        }
+    /**
+     * @brief 内部ログ出力処理（全出力先に対して実行）
+     * @details フォーマット用バッファは呼び出しスレッド専用のものを使う
+     * （スレッド間で共有する状態は無く、ロック不要）
+     * @param message ANSI版メッセージ
+     * @param plain タグ除去版メッセージ
+     * @param runtime_tags 引数由来の色タグが残っているか
+     * （残っていれば、フォーマッタが解析時に検証する）
+     * @param site 呼び出し箇所（描画済みヘッダを持つ、無ければnullptr）
+     * @param format payloadのフォーマット（無ければnullptr）
+     * @param payload 引数の生バイト（遅延フォーマットのみ、無ければnullptr）
+     * @param pairs 出力するペアのビット（チャネルの出力先、既定は全ペア）
+     */
+    void log_internal(LogLevel level, const char* file, int line,
+                      timestamp_t time, const char* message, const char* plain,
+                      bool runtime_tags, const CallSite* site,
+                      const FormatInfo* format = nullptr,
+                      const char* payload = nullptr, size_t payload_len = 0,
+                      uint32_t pairs = ~0u) {
+        dispatch(create_log_entry(level, file, line, time, message, plain,
+                                  runtime_tags, site,
+                                  Memory::thread_staging(), format, payload,
+                                  payload_len),
+                 pairs);
+    }
 
-        free(entry.formatedMsg);  // バッファ解放
+    /**
+     * @brief 出力ペアの集合を公開し、古い集合を猶予期間の後に解放
+     * @details 先に新旧の版の和を整形させ、それより前に整形されたレコード
+     * （非同期キューの中のものを含む）を古い集合で出し切ってから切り替える。
+     * ログを出すスレッドは待たせず、どちらの集合に渡ったレコードも捨てない。
+     * config_mutexを持って呼ぶ
+     */
+    void publish(PairSet* next) {
+        PairSet* old = output_pairs.load(std::memory_order_relaxed);
+        store_wanted(old->packed_wanted() | next->packed_wanted());
+        Rcu::synchronize();
+        flush();
+        output_pairs.store(next, std::memory_order_seq_cst);
+        Rcu::synchronize();
+        store_wanted(next->packed_wanted());
+        delete old;  // 外したペアのwriterはデストラクタでflushされる
+    }
+
+    /**
+     * @brief LoggerPairのベクターから最初の集合を作る
+     */
+    void init_pairs(std::vector<LoggerPair> pairs) {
+        std::vector<std::shared_ptr<LoggerPair>> list;
+        list.reserve(pairs.size());
+        for (auto& pair : pairs) {
+            list.push_back(std::make_shared<LoggerPair>(std::move(pair)));
+        }
+        PairSet* set = new PairSet(std::move(list));
+        store_wanted(set->packed_wanted());
+        output_pairs.store(set, std::memory_order_release);
+        Time::Clock::instance();  // 時計の較正を最初のログより前に済ませる
+#if LOG_DEDUP
+        dedup.reset(Memory::aligned_new<Dedup::Tracker>());
+#endif
     }
 
    public:
@@ -73,52 +551,398 @@ class Logger {
      * @brief 複数出力ペア対応コンストラクタ
      * @param pairs 出力ペアのベクター
      */
-    Logger(std::vector<LoggerPair> pairs)
-        : current_level(LogLevel::INFO_), output_pairs(std::move(pairs)) {}
+    Logger(std::vector<LoggerPair> pairs) { init_pairs(std::move(pairs)); }
 
     /**
      * @brief 単一ペア用コンストラクタ
      */
     Logger(std::unique_ptr<Formatters::FormatterBase> fmt,
-           std::unique_ptr<Writers::IWriter> wrt)
-        : current_level(LogLevel::INFO_) {
-        output_pairs.emplace_back(std::move(fmt), std::move(wrt));
+           std::unique_ptr<Writers::IWriter> wrt) {
+        std::vector<LoggerPair> pairs;
+        pairs.emplace_back(std::move(fmt), std::move(wrt));
+        init_pairs(std::move(pairs));
+    }
+
+    /**
+     * @brief デストラクタ
+     * @details 非同期キュー・集約中の繰り返しを全て出力してから、
+     * 出力ペアを解放する（writerはデストラクタでflushされる）
+     */
+    ~Logger() {
+#if LOG_ASYNC
+        stop_async();
+#elif LOG_DEDUP
+        flush_writers();
+#endif
+        delete output_pairs.load(std::memory_order_acquire);
+    }
+
+#if LOG_ASYNC
+    /**
+     * @brief 非同期モードを開始
+     * @details 以降のlog_outputはキューに積むだけで戻る。
+     * キュー領域の確保はここでの1回のみ
+     */
+    void start_async() {
+        if (async_running.load(std::memory_order_acquire)) {
+            return;
+        }
+        if (!queue) {
+            queue.reset(Memory::aligned_new<Queue>());
+        }
+        backend_stop.store(false, std::memory_order_relaxed);
+        async_running.store(true, std::memory_order_release);
+        backend = std::thread(&Logger::backend_loop, this);
+    }
+
+    /**
+     * @brief 非同期モードを停止
+     * @details キューに残った全レコードを出力・flushしてから戻る。
+     * 呼び出し後のlog_outputは同期出力に戻る。
+     * 生産者はasync_runningの確認からキューへの公開までを読み取り区間の
+     * 中で行うので、猶予期間を待てば判定を通った生産者は全て積み終えて
+     * いる。その後でバックエンドを止め、最後の取り出しをさせる
+     */
+    void stop_async() {
+        if (!async_running.exchange(false, std::memory_order_seq_cst)) {
+            return;
+        }
+        Rcu::synchronize();
+        backend_stop.store(true, std::memory_order_release);
+        if (backend.joinable()) {
+            backend.join();
+        }
+    }
+
+    /**
+     * @brief キュー満杯で破棄されたレコード数を取得
+     */
+    size_t get_dropped_count() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+#endif
+
+    /**
+     * @brief 指定レベルが出力対象か
+     * @details LOG_*マクロは引数を評価する前にこれで判定する。
+     * Loggerのレベルとペアの有無を1語から1回読んで判定する
+     * @param level ログレベル
+     * @return 出力対象ならtrue
+     */
+    bool is_enabled(LogLevel level) const {
+        const uint32_t want = wanted.load(std::memory_order_relaxed) >>
+                              (8 * static_cast<int>(level));
+        // LEVEL_ONが立ち、かつ版のビットがどれか立っている
+        return (want & (PairSet::LEVEL_ON | PairSet::WANT_ALL)) >
+               PairSet::LEVEL_ON;
+    }
+
+    /**
+     * @brief is_enabledと同じ判定をし、levelを受ける版も返す（LOG_*_LAZY用）
+     * @details 呼び出し箇所のスイッチでONにされた場合はLoggerのレベルを
+     * 見ないので、出力ペアの有無は同じ1回の読み込みから得たwantで判定する
+     * @param want levelを受ける版（WANT_*の和、0なら受けるペアが無い）
+     */
+    bool is_enabled(LogLevel level, uint8_t& want) const {
+        const uint32_t bits = wanted.load(std::memory_order_relaxed) >>
+                              (8 * static_cast<int>(level));
+        want = static_cast<uint8_t>(bits & PairSet::WANT_ALL);
+        return (bits & (PairSet::LEVEL_ON | PairSet::WANT_ALL)) >
+               PairSet::LEVEL_ON;
+    }
+
+    /**
+     * @brief levelを受ける出力ペアがあるか（Loggerのレベルは見ない）
+     * @details 構成時に求めたレベル毎の版を1語から読むだけ
+     */
+    bool accepts(LogLevel level) const {
+        return (wanted.load(std::memory_order_relaxed) >>
+                    (8 * static_cast<int>(level)) &
+                PairSet::WANT_ALL) != 0;
+    }
+
+#if LOG_DEFERRED
+    /**
+     * @brief 遅延フォーマット版のログ出力
+     * @details フォーマット文字列のポインタと引数の生バイトだけを記録する。
+     * 整形は非同期バックエンドで行う（同期時はその場でデコード）。
+     * fmtの文字列は出力されるまで生存するもの（リテラルなど）であること
+     */
+    template <typename... Args>
+    void log_output(LogLevel level, const char* file, int line,
+                    const FormatInfo* fmt, const Args&... args) {
+        // 引数のキャプチャより先にレベルで弾く
+        if (!is_enabled(level)) {
+            return;
+        }
+        log_args(level, file, line, fmt, args...);
     }
 
-    // 可変引数処理用ヘルパー関数
+    /**
+     * @brief フォーマット文字列をそのまま受け取る版（色タグは実行時に解析）
+     */
+    template <typename... Args>
+    void log_output(LogLevel level, const char* file, int line,
+                    const char* fmt, const Args&... args) {
+        const FormatInfo info = {fmt, fmt, true, nullptr, nullptr};
+        log_output(level, file, line, &info, args...);
+    }
+
+    /**
+     * @brief レベル判定済みのログ出力（遅延フォーマット）
+     * @details 呼び出し側で判定を済ませたマクロ（LOG_CH、LOG_*_LAZY）用。
+     * Loggerのレベルは見ない
+     */
+    template <typename... Args>
+    void log_args(LogLevel level, const char* file, int line,
+                  const FormatInfo* fmt, const Args&... args) {
+        Rcu::ReadGuard guard;  // 整形した版と出力ペアの組を揃える
+        if (!accepts(level)) {
+            return;  // 受けるペアが無い（LOG_CHなどLoggerのレベルを見ない経路）
+        }
+#if LOG_ASYNC
+        if (async_running.load(std::memory_order_acquire)) {
+            size_t ticket;
+            Async::Record* rec = claim_record(ticket, level, file, line);
+            if (rec == nullptr) {
+                return;
+            }
+            rec->fmt = *fmt;
+            rec->payload_len = static_cast<uint16_t>(
+                Deferred::encode(rec->payload, sizeof(rec->payload), args...));
+            queue->publish(ticket);
+            return;
+        }
+#endif
+        const timestamp_t time = Time::now();
+        char payload[LOG_MSG_SIZE];
+        payload[0] = '\0';  // 引数なしの場合も初期化済みにする
+        size_t len = Deferred::encode(payload, sizeof(payload), args...);
+#if LOG_DEDUP
+        if (drop_repeat(*fmt, time, payload, len)) {
+            return;
+        }
+#endif
+        char msg[LOG_MSG_SIZE];
+        char plain[LOG_MSG_SIZE];
+        int variants = decode_message(level, *fmt, payload, len, msg, plain);
+        log_variants(level, file, line, time, *fmt, variants, msg, plain,
+                     payload, len);
+    }
+#else
+    /**
+     * @brief 可変引数処理用ヘルパー関数
+     * @param fmt LOG_*マクロがコンパイル時に色タグを変換したフォーマット
+     */
+    void log_output(LogLevel level, const char* file, int line,
+                    const FormatInfo* fmt, ...) {
+        // 引数のフォーマットより先にレベルで弾く
+        if (!is_enabled(level)) {
+            return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        vlog_output(level, file, line, *fmt, args);
+        va_end(args);
+    }
+
+    /**
+     * @brief フォーマット文字列をそのまま受け取る版（色タグは実行時に解析）
+     */
     void log_output(LogLevel level, const char* file, int line, const char* fmt,
                     ...) {
+        if (!is_enabled(level)) {
+            return;
+        }
         va_list args;
         va_start(args, fmt);
-        char msg[256];
-        vsnprintf(msg, sizeof(msg), fmt, args);
+        vlog_output(level, file, line,
+                    FormatInfo{fmt, fmt, true, nullptr, nullptr},
+                    args);
         va_end(args);
-        log_internal(level, file, line, msg);
     }
 
+    /**
+     * @brief va_list版のログ出力
+     */
+    void vlog_output(LogLevel level, const char* file, int line,
+                     const FormatInfo& fmt, va_list args) {
+        Rcu::ReadGuard guard;  // 整形した版と出力ペアの組を揃える
+        if (!accepts(level)) {
+            return;  // 受けるペアが無い（LOG_CHなどLoggerのレベルを見ない経路）
+        }
+#if LOG_ASYNC
+        if (async_running.load(std::memory_order_acquire)) {
+            enqueue(level, file, line, fmt, args);
+            return;
+        }
+#endif
+        const timestamp_t time = Time::now();
+        char msg[LOG_MSG_SIZE];
+        char plain[LOG_MSG_SIZE];
+        int variants = format_message(level, fmt, args, msg, plain);
+#if LOG_DEDUP
+        if (drop_repeat(fmt, time, variants, msg, plain)) {
+            return;
+        }
+#endif
+        log_variants(level, file, line, time, fmt, variants, msg, plain);
+    }
+
+    /**
+     * @brief レベル判定済みのログ出力
+     * @details 呼び出し側で判定を済ませたマクロ（LOG_CH、LOG_*_LAZY）用。
+     * Loggerのレベルは見ない
+     */
+    void log_args(LogLevel level, const char* file, int line,
+                  const FormatInfo* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        vlog_output(level, file, line, *fmt, args);
+        va_end(args);
+    }
+#endif
+
+    /**
+     * @brief メッセージを関数で作る版のログ出力（LOG_*_LAZYから呼ばれる）
+     * @details レベルと出力ペアの有無の判定は呼び出し側（マクロ）が
+     * is_enabledの1回の読み込みで済ませてあり、ここでは読み直さない
+     * @param fmt "%s"（LOG_CT_FORMATで呼び出し箇所を付けたもの）
+     * @param producer void(Utils::LineBuilder&)、または文字列
+     * （const char*、data()/size()を持つもの）を返す関数
+     */
+    template <typename Producer>
+    void log_lazy(LogLevel level, const char* file, int line,
+                  const FormatInfo* fmt, Producer&& producer) {
+        char text[LOG_MSG_SIZE];
+        Utils::LineBuilder out(text, sizeof(text));
+        produce(producer, out, 0);
+        log_args(level, file, line, fmt, static_cast<const char*>(text));
+    }
+
+    /**
+     * @brief 全出力先をflush
+     * @details 非同期モードでは、呼び出し時点までに積まれたレコードが
+     * 全て出力されるまで待つ
+     */
     void flush() {
-        for (auto& pair : output_pairs) {
-            pair.writer->flush();
+#if LOG_ASYNC
+        if (async_running.load(std::memory_order_acquire)) {
+            size_t target = queue->claimed();
+            size_t request = flush_request.load(std::memory_order_relaxed);
+            while (request < target &&
+                   !flush_request.compare_exchange_weak(
+                       request, target, std::memory_order_release)) {
+            }
+            while (flush_done.load(std::memory_order_acquire) < target &&
+                   async_running.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            return;
         }
+#endif
+        flush_writers();
     }
 
     /**
      * @brief 最小ログレベルを設定
+     * @details ログを出すスレッドと同時に呼べる（ロックするのは設定側同士
+     * だけ。is_enabledが読む1語へレベルを重ね直す）
      * @param level 設定するログレベル
      */
-    void set_level(LogLevel level) { current_level = level; }
+    void set_level(LogLevel level) {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        current_level.store(level, std::memory_order_relaxed);
+        store_wanted(wanted.load(std::memory_order_relaxed) &
+                     ~(0x01010101u * PairSet::LEVEL_ON));
+    }
 
     /**
      * @brief 現在のログレベルを取得
      * @return 現在のログレベル
      */
-    LogLevel get_level() const { return current_level; }
+    LogLevel get_level() const {
+        return current_level.load(std::memory_order_relaxed);
+    }
 
     /**
      * @brief 出力ペア数を取得
      * @return 設定されている出力ペアの数
      */
-    size_t get_output_count() const { return output_pairs.size(); }
+    size_t get_output_count() const {
+        Rcu::ReadGuard guard;
+        return output_pairs.load(std::memory_order_seq_cst)->pairs.size();
+    }
+
+    /**
+     * @brief 現在の出力ペアを取得
+     * @details 要素を並べ替え・追加してreplace_pairsへ渡す用
+     */
+    std::vector<std::shared_ptr<LoggerPair>> get_pairs() {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        return output_pairs.load(std::memory_order_relaxed)->pairs;
+    }
+
+    /**
+     * @brief 出力ペアを差し替える
+     * @details 新しい集合を公開し、古い集合を読んでいるスレッドが
+     * 無くなるのを待ってから解放する。ログを出すスレッドはロックされず、
+     * レコードも捨てない。差し替えの間、呼び出し側は待たされる。
+     * ログ出力の途中（writerやフォーマッタの中）からは呼ばないこと
+     * @param pairs 新しい出力ペア（引き続き使うペアはget_pairsの要素）
+     */
+    void replace_pairs(std::vector<std::shared_ptr<LoggerPair>> pairs) {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        publish(new PairSet(std::move(pairs)));
+    }
+
+    /**
+     * @brief 出力ペアを末尾に追加（障害時にファイル出力を付けるなど）
+     * @param level このペアへ出す最小レベル
+     */
+    void add_pair(std::unique_ptr<Formatters::FormatterBase> fmt,
+                  std::unique_ptr<Writers::IWriter> wrt,
+                  LogLevel level = LogLevel::DEBUG_) {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        auto pairs = output_pairs.load(std::memory_order_relaxed)->pairs;
+        pairs.push_back(std::make_shared<LoggerPair>(std::move(fmt),
+                                                     std::move(wrt), level));
+        publish(new PairSet(std::move(pairs)));
+    }
+
+    /**
+     * @brief index番目の出力ペアの最小レベルを設定
+     * @details レベル毎のビットを求め直した集合を公開する（差し替えと同じく
+     * ログを出すスレッドはロックされない）
+     * @return indexが範囲外ならfalse
+     */
+    bool set_pair_level(size_t index, LogLevel level) {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        auto pairs = output_pairs.load(std::memory_order_relaxed)->pairs;
+        if (index >= pairs.size()) {
+            return false;
+        }
+        pairs[index]->min_level = level;
+        publish(new PairSet(std::move(pairs)));
+        return true;
+    }
+
+    /**
+     * @brief index番目の出力ペアを外す
+     * @details 外したペアのwriterは、渡っていたレコードを書き終えてから
+     * 解放（flush）される。後ろのペアの番号は1つずつ詰まる
+     * @return indexが範囲外ならfalse
+     */
+    bool remove_pair(size_t index) {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        auto pairs = output_pairs.load(std::memory_order_relaxed)->pairs;
+        if (index >= pairs.size()) {
+            return false;
+        }
+        pairs.erase(pairs.begin() + index);
+        publish(new PairSet(std::move(pairs)));
+        return true;
+    }
 };
 
 }  // namespace logger
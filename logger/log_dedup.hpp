@@ -0,0 +1,172 @@
+/**
+ * @file log_dedup.hpp
+ * @brief 繰り返しログの集約
+ * @details 同じ呼び出し箇所から同じ引数のレコードが続いたら2件目以降を
+ * 捨てて数だけ数え、続きが途切れたとき・一定時間毎・flush時に
+ * "last message repeated N times"を1行出す。同一かどうかは呼び出し箇所の
+ * ポインタと引数のハッシュだけで判定する（文字列比較はしない）
+ * @author ren255
+ */
+
+#ifndef LOG_DEDUP_HPP
+#define LOG_DEDUP_HPP
+
+#include <atomic>   // ロックフリー同期（std::atomic）
+#include <cstdint>  // uint64_t
+#include <cstring>  // memcpy
+
+namespace logger {
+/**
+ * @brief 繰り返しの集約を提供する名前空間
+ */
+namespace Dedup {
+
+/**
+ * @brief 引数のバイト列のハッシュ
+ * @details 8バイトずつ掛け算で混ぜる（1行分で数十サイクル）。
+ * 0は「未使用」を表すので返さない
+ */
+inline uint64_t hash(const char* data, size_t len) {
+    const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    uint64_t h = len * PRIME;
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        h = (h ^ word) * PRIME;
+        h ^= h >> 29;
+        data += 8;
+        len -= 8;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data, len);
+    h = (h ^ tail) * PRIME;
+    h ^= h >> 32;
+    return h | 1;
+}
+
+/**
+ * @brief 出すべき集約行
+ */
+struct Summary {
+    const CallSite* site = nullptr;
+    const Channels::Channel* channel = nullptr;  ///< LOG_CHのチャネル
+    uint32_t count = 0;     ///< 捨てた数（0なら出す行は無い）
+    timestamp_t first = 0;  ///< 続きの先頭（最初に出力したレコード）の時刻
+    timestamp_t last = 0;   ///< 最後に捨てたレコードの時刻
+};
+
+/**
+ * @brief 呼び出し箇所毎の直前のレコード
+ * @details 呼び出し箇所のポインタをキーにしたロックフリーの開番地法の表。
+ * 続いているかの判定は読み込み1回、捨てる場合はそれに加算と書き込み。
+ * 同じ呼び出し箇所から複数スレッドが異なる引数で同時に出すと、
+ * 境目の数件がどちらの続きに数えられるかは前後しうる（合計は変わらない）
+ */
+class Tracker {
+   private:
+    struct alignas(64) Slot {
+        std::atomic<const CallSite*> site{nullptr};
+        std::atomic<uint64_t> hash{0};       // 直前のレコードの引数
+        std::atomic<const Channels::Channel*> channel{nullptr};
+        std::atomic<uint32_t> repeats{0};    // 捨てた数
+        std::atomic<timestamp_t> first{0};   // 続きの先頭の時刻
+        std::atomic<timestamp_t> last{0};    // 最後に捨てた時刻
+    };
+
+    Slot slots[LOG_DEDUP_SITES];
+
+    Slot* find(const CallSite* site) {
+        const size_t mask = LOG_DEDUP_SITES - 1;
+        size_t index = static_cast<size_t>(
+            (reinterpret_cast<uintptr_t>(site) >> 3) * 0x9E3779B97F4A7C15ull >>
+            32);
+        for (size_t probe = 0; probe < LOG_DEDUP_SITES; probe++) {
+            Slot& slot = slots[(index + probe) & mask];
+            const CallSite* current = slot.site.load(std::memory_order_acquire);
+            if (current == nullptr &&
+                slot.site.compare_exchange_strong(current, site,
+                                                  std::memory_order_acq_rel)) {
+                return &slot;
+            }
+            if (current == site) {
+                return &slot;
+            }
+        }
+        return nullptr;  // 表が満杯なら集約しない
+    }
+
+    static Summary take(Slot& slot, const CallSite* site) {
+        Summary summary;
+        summary.count = slot.repeats.exchange(0, std::memory_order_relaxed);
+        if (summary.count != 0) {
+            summary.site = site;
+            summary.channel = slot.channel.load(std::memory_order_relaxed);
+            summary.first = slot.first.load(std::memory_order_relaxed);
+            summary.last = slot.last.load(std::memory_order_relaxed);
+        }
+        return summary;
+    }
+
+   public:
+    /**
+     * @brief レコードが直前と同じか判定
+     * @param site 呼び出し箇所
+     * @param channel LOG_CHのチャネル（集約行の出力先に使う）
+     * @param hash 引数のハッシュ（Dedup::hash）
+     * @param now レコードの時刻
+     * @param summary 先に出すべき集約行（続きが途切れた・時間が経った場合）
+     * @return 直前と同じで捨てるべきならtrue
+     */
+    bool repeated(const CallSite* site, const Channels::Channel* channel,
+                  uint64_t hash, timestamp_t now, Summary& summary) {
+        Slot* slot = find(site);
+        if (slot == nullptr) {
+            return false;
+        }
+        if (slot->hash.load(std::memory_order_relaxed) == hash) {
+            slot->repeats.fetch_add(1, std::memory_order_relaxed);
+            slot->last.store(now, std::memory_order_relaxed);
+            // 続いたままLOG_DEDUP_TIMEOUT_MSを過ぎたら途中経過を出す
+            timestamp_t first = slot->first.load(std::memory_order_relaxed);
+            if (now - first >= LOG_DEDUP_TIMEOUT_MS * 1000000 &&
+                slot->first.compare_exchange_strong(
+                    first, now, std::memory_order_relaxed)) {
+                summary = take(*slot, site);
+                summary.channel = channel;
+                summary.first = first;
+            }
+            return true;
+        }
+        slot->channel.store(channel, std::memory_order_relaxed);
+        slot->hash.store(hash, std::memory_order_relaxed);
+        summary = take(*slot, site);
+        summary.channel = channel;
+        slot->first.store(now, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * @brief 数えている途中の集約行を全て取り出す（flush時）
+     * @param emit Summaryを受け取る関数
+     */
+    template <typename Fn>
+    void drain(Fn emit) {
+        for (Slot& slot : slots) {
+            const CallSite* site = slot.site.load(std::memory_order_acquire);
+            if (site == nullptr ||
+                slot.repeats.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            Summary summary = take(slot, site);
+            if (summary.count != 0) {
+                slot.first.store(summary.last, std::memory_order_relaxed);
+                emit(summary);
+            }
+        }
+    }
+};
+
+}  // namespace Dedup
+}  // namespace logger
+
+#endif  // LOG_DEDUP_HPP
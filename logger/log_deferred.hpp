@@ -0,0 +1,424 @@
+/**
+ * @file log_deferred.hpp
+ * @brief 遅延フォーマット用の引数キャプチャ
+ * @details 呼び出し側では引数の生バイトを詰めるだけにし、
+ * printf相当の整形は後段（バックエンドスレッドやデコーダ）で行う
+ * @author ren255
+ */
+
+#ifndef LOG_DEFERRED_HPP
+#define LOG_DEFERRED_HPP
+
+#include <cstddef>      // ptrdiff_t
+#include <cstdint>      // uint8_t, uint16_t, intmax_t
+#include <type_traits>  // std::enable_if, std::is_integral など
+
+namespace logger {
+/**
+ * @brief 遅延フォーマットを提供する名前空間
+ */
+namespace Deferred {
+
+/**
+ * @brief 引数の型タグ（ペイロード先頭1バイト）
+ */
+enum class ArgType : uint8_t {
+    INT,      ///< 符号付き整数（int64_tで格納）
+    UINT,     ///< 符号なし整数（uint64_tで格納）
+    DOUBLE,   ///< 浮動小数点（doubleで格納）
+    STRING,   ///< 文字列（uint16_t長 + '\0'終端の本体）
+    POINTER,  ///< ポインタ（uintptr_tで格納）
+};
+
+/**
+ * @brief 引数をペイロードに詰めるクラス
+ * @details 文字列は呼び出し後に消える可能性があるため内容ごとコピーする。
+ * 容量を超えた引数は捨て、デコード時は空として扱われる
+ */
+class ArgEncoder {
+   private:
+    char* buffer;
+    size_t capacity;
+    size_t pos = 0;
+
+    template <typename T>
+    void put_raw(ArgType type, T value) {
+        if (pos + 1 + sizeof(T) > capacity) {
+            pos = capacity;  // 以降の引数も捨てる
+            return;
+        }
+        buffer[pos++] = static_cast<char>(type);
+        memcpy(buffer + pos, &value, sizeof(T));
+        pos += sizeof(T);
+    }
+
+   public:
+    ArgEncoder(char* buf, size_t cap) : buffer(buf), capacity(cap) {}
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                            std::is_signed<T>::value>::type
+    put(T value) {
+        put_raw(ArgType::INT, static_cast<int64_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                            std::is_unsigned<T>::value>::type
+    put(T value) {
+        put_raw(ArgType::UINT, static_cast<uint64_t>(value));
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value>::type put(
+        T value) {
+        put_raw(ArgType::DOUBLE, static_cast<double>(value));
+    }
+
+    /**
+     * @brief 列挙型は基底の整数型として詰める
+     */
+    template <typename T>
+    typename std::enable_if<std::is_enum<T>::value>::type put(T value) {
+        put(static_cast<typename std::underlying_type<T>::type>(value));
+    }
+
+    void put(const char* str) {
+        if (str == nullptr) {
+            str = "(null)";
+        }
+        size_t len = strlen(str);
+        if (pos + 1 + sizeof(uint16_t) + 1 > capacity) {
+            pos = capacity;
+            return;
+        }
+        // 入り切らない分は切り詰める
+        size_t room = capacity - pos - 1 - sizeof(uint16_t) - 1;
+        if (len > room) len = room;
+        if (len > UINT16_MAX) len = UINT16_MAX;
+
+        uint16_t len16 = static_cast<uint16_t>(len);
+        buffer[pos++] = static_cast<char>(ArgType::STRING);
+        memcpy(buffer + pos, &len16, sizeof(len16));
+        pos += sizeof(len16);
+        memcpy(buffer + pos, str, len);
+        pos += len;
+        buffer[pos++] = '\0';
+    }
+
+    template <typename T>
+    void put(const T* ptr) {
+        put_raw(ArgType::POINTER, reinterpret_cast<uintptr_t>(ptr));
+    }
+
+    void put(std::nullptr_t) { put_raw(ArgType::POINTER, uintptr_t(0)); }
+
+    /**
+     * @brief 詰めたバイト数
+     */
+    size_t size() const { return pos; }
+};
+
+/**
+ * @brief 引数群をペイロードへ詰める
+ * @param buf 出力先
+ * @param cap 出力先の容量
+ * @param args printf互換の引数
+ * @return 使用したバイト数
+ */
+template <typename... Args>
+size_t encode(char* buf, size_t cap, const Args&... args) {
+    ArgEncoder encoder(buf, cap);
+    int expand[] = {0, (encoder.put(args), 0)...};
+    (void)expand;
+    return encoder.size();
+}
+
+/**
+ * @brief ペイロードから引数を1つずつ取り出すクラス
+ */
+class ArgDecoder {
+   private:
+    const char* payload;
+    size_t length;
+    size_t pos = 0;
+
+   public:
+    /**
+     * @brief 取り出した引数
+     */
+    struct Arg {
+        ArgType type;
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+            const char* s;
+            uintptr_t p;
+        };
+        bool valid;
+    };
+
+    ArgDecoder(const char* data, size_t len) : payload(data), length(len) {}
+
+    /**
+     * @brief 次の引数を取り出す
+     * @return 引数（残りが無い場合valid=false）
+     */
+    Arg next() {
+        Arg arg;
+        arg.valid = false;
+        arg.type = ArgType::INT;
+        arg.u = 0;
+        if (pos >= length) {
+            return arg;
+        }
+        arg.type = static_cast<ArgType>(payload[pos++]);
+        switch (arg.type) {
+            case ArgType::STRING: {
+                uint16_t len16;
+                memcpy(&len16, payload + pos, sizeof(len16));
+                pos += sizeof(len16);
+                arg.s = payload + pos;
+                pos += len16 + 1;
+                break;
+            }
+            case ArgType::DOUBLE:
+                memcpy(&arg.d, payload + pos, sizeof(arg.d));
+                pos += sizeof(arg.d);
+                break;
+            case ArgType::POINTER:
+                memcpy(&arg.p, payload + pos, sizeof(arg.p));
+                pos += sizeof(arg.p);
+                break;
+            default:  // INT, UINT
+                memcpy(&arg.u, payload + pos, sizeof(arg.u));
+                pos += sizeof(arg.u);
+                break;
+        }
+        arg.valid = true;
+        return arg;
+    }
+};
+
+/**
+ * @brief 取り出した引数を整数として読む（'*'幅指定など）
+ */
+inline long long arg_as_int(const ArgDecoder::Arg& arg) {
+    switch (arg.type) {
+        case ArgType::DOUBLE:
+            return static_cast<long long>(arg.d);
+        case ArgType::STRING:
+            return 0;
+        default:
+            return arg.valid ? static_cast<long long>(arg.i) : 0;
+    }
+}
+
+/**
+ * @brief 長さ修飾子を読み、整数変換が読む引数のバイト数を返す
+ * @details 修飾子が無ければint。pは修飾子の後ろへ進む
+ */
+inline int length_modifier(const char*& p) {
+    int bytes = sizeof(int);
+    switch (*p) {
+        case 'h':
+            bytes = p[1] == 'h' ? 1 : sizeof(short);
+            break;
+        case 'l':
+            bytes = p[1] == 'l' ? sizeof(long long) : sizeof(long);
+            break;
+        case 'j':
+            bytes = sizeof(intmax_t);
+            break;
+        case 'z':
+            bytes = sizeof(size_t);
+            break;
+        case 't':
+            bytes = sizeof(ptrdiff_t);
+            break;
+        case 'q':
+            bytes = sizeof(long long);
+            break;
+        default:  // 'L'は浮動小数点（格納はdouble）
+            break;
+    }
+    while (*p != '\0' && strchr("hljztLq", *p) != nullptr) {
+        p++;
+    }
+    return bytes;
+}
+
+/**
+ * @brief 格納した整数をbytesバイトの符号付き整数として読む
+ * @details printfが長さ修飾子の型で引数を読むのと同じく、上位を切り捨てて
+ * 符号拡張する
+ */
+inline long long narrow_signed(const ArgDecoder::Arg& arg, int bytes) {
+    uint64_t value = static_cast<uint64_t>(arg_as_int(arg));
+    if (bytes >= 8) {
+        return static_cast<long long>(value);
+    }
+    const int shift = 64 - 8 * bytes;
+    return static_cast<long long>(static_cast<int64_t>(value << shift) >>
+                                  shift);
+}
+
+/**
+ * @brief 格納した整数をbytesバイトの符号なし整数として読む
+ */
+inline unsigned long long narrow_unsigned(const ArgDecoder::Arg& arg,
+                                          int bytes) {
+    uint64_t value = static_cast<uint64_t>(arg_as_int(arg));
+    return bytes >= 8 ? value : value & ((uint64_t(1) << (8 * bytes)) - 1);
+}
+
+/**
+ * @brief 変換指定1つ分を整形
+ * @param spec 長さ修飾子を除いた変換指定（例: "%-8.3"）
+ * @param conv 変換文字
+ * @param bytes 長さ修飾子が示す整数のバイト数（length_modifier）
+ * @param stars '*'で取り出した幅・精度
+ * @param star_count '*'の数（0〜2）
+ * @return snprintfの戻り値
+ */
+inline int format_one(char* out, size_t cap, char* spec, size_t spec_len,
+                      char conv, int bytes, const int* stars, int star_count,
+                      const ArgDecoder::Arg& arg) {
+    // 修飾子の幅へ揃えた値をlong longで渡す
+    switch (conv) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            if (conv != 'c') {
+                spec[spec_len++] = 'l';
+                spec[spec_len++] = 'l';
+            }
+            break;
+        default:
+            break;
+    }
+    spec[spec_len++] = conv;
+    spec[spec_len] = '\0';
+
+#define LOG_DEFERRED_PRINT(value)                                            \
+    (star_count == 0   ? snprintf(out, cap, spec, value)                     \
+     : star_count == 1 ? snprintf(out, cap, spec, stars[0], value)           \
+                       : snprintf(out, cap, spec, stars[0], stars[1], value))
+
+    switch (conv) {
+        case 'd':
+        case 'i':
+            return LOG_DEFERRED_PRINT(narrow_signed(arg, bytes));
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            return LOG_DEFERRED_PRINT(narrow_unsigned(arg, bytes));
+        case 'c':
+            return LOG_DEFERRED_PRINT(static_cast<int>(arg_as_int(arg)));
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A': {
+            double d = (arg.type == ArgType::DOUBLE)
+                           ? arg.d
+                           : static_cast<double>(arg_as_int(arg));
+            return LOG_DEFERRED_PRINT(d);
+        }
+        case 's':
+            return LOG_DEFERRED_PRINT(
+                (arg.valid && arg.type == ArgType::STRING) ? arg.s : "");
+        case 'p':
+            return LOG_DEFERRED_PRINT(reinterpret_cast<void*>(arg.p));
+        default:
+            return 0;  // %n など未対応の変換は出力しない
+    }
+#undef LOG_DEFERRED_PRINT
+}
+
+/**
+ * @brief フォーマット文字列とペイロードからメッセージを組み立てる
+ * @details vsnprintf相当。変換指定毎にペイロードから引数を取り出して整形する
+ * @param fmt フォーマット文字列
+ * @param payload encodeで詰めたペイロード
+ * @param len ペイロードのバイト数
+ * @param out 出力バッファ
+ * @param cap 出力バッファの容量
+ * @return 出力文字数（'\0'を除く）
+ */
+inline size_t format(const char* fmt, const char* payload, size_t len,
+                     char* out, size_t cap) {
+    ArgDecoder decoder(payload, len);
+    size_t pos = 0;
+    if (cap == 0) return 0;
+
+    const char* p = fmt;
+    while (*p != '\0' && pos + 1 < cap) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // 変換指定を読む: %[flags][width][.precision][length]conv
+        char spec[32];
+        size_t spec_len = 0;
+        int stars[2];
+        int star_count = 0;
+        spec[spec_len++] = *p++;
+        while (*p != '\0' && strchr("-+ #0", *p) != nullptr &&
+               spec_len < 8) {
+            spec[spec_len++] = *p++;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*p != '.') break;
+                spec[spec_len++] = *p++;
+            }
+            if (*p == '*') {
+                stars[star_count++] =
+                    static_cast<int>(arg_as_int(decoder.next()));
+                spec[spec_len++] = *p++;
+            } else {
+                while (*p >= '0' && *p <= '9' && spec_len < 24) {
+                    spec[spec_len++] = *p++;
+                }
+            }
+        }
+        const int bytes = length_modifier(p);
+        if (*p == '\0') {
+            break;
+        }
+        char conv = *p++;
+
+        int written =
+            format_one(out + pos, cap - pos, spec, spec_len, conv, bytes,
+                       stars, star_count, decoder.next());
+        if (written > 0) {
+            pos += static_cast<size_t>(written);
+            if (pos >= cap) {
+                pos = cap - 1;
+            }
+        }
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+}  // namespace Deferred
+}  // namespace logger
+
+#endif  // LOG_DEFERRED_HPP
@@ -10,7 +10,6 @@
 
 #include "logger.hpp"
 #include <cstring>
-#include <cstdio>
 
 namespace logger {
 /**
@@ -32,42 +31,83 @@ class FormatterBase {
     virtual ~FormatterBase() = default;
 
     /**
-     * @brief ログエントリをフォーマット
-     * @param entry ログエントリ（formatedMsgバッファに出力される）
+     * @brief ログエントリを1行にフォーマット
+     * @details writerのバッファ（またはformatedMsg）へ直接書き込む。
+     * 改行は付けない
+     * @param entry ログエントリ
+     * @param out 出力先
+     * @param size 出力先のサイズ（'\0'を含む）
+     * @return 出力文字数（'\0'を除く）
      */
-    virtual void format(const LogEntry& entry) = 0;
+    virtual size_t format(const LogEntry& entry, char* out, size_t size) = 0;
+
+    /**
+     * @brief ANSIカラーを出力するか
+     * @details trueならANSI版、falseならタグ除去版のメッセージを受け取る
+     */
+    virtual bool uses_color() const { return false; }
+
+    /**
+     * @brief 整形済みのメッセージを使うか
+     * @details falseのフォーマッタはLogEntryのpayload（遅延フォーマットの
+     * 引数）から直接書く。payloadが無いエントリではタグ除去版を受け取る
+     */
+    virtual bool uses_message() const { return true; }
 
    protected:
+    Time::Precision time_precision = Time::Precision::NONE;  // 行頭の時刻
+
+    /**
+     * @brief 引数由来の色タグを処理した本文
+     */
+    struct Body {
+        char text[LOG_FMT_SIZE];
+        size_t len = 0;
+        bool staged = false;   ///< textに変換・除去済みの本文がある
+        bool invalid = false;  ///< 色タグが不正
+    };
+
     /**
-     * @brief レベル文字列をパディング
-     * @param level_str レベル文字列
-     * @param output 出力バッファ（target_width+1以上のサイズが必要）
-     * @param target_width 目標幅（デフォルト8）
+     * @brief 出力するレベルを決定
+     * @details 引数由来の色タグが残っている場合は、ヘッダより先に本文を
+     * bodyへ1パスで変換・除去し、その検証結果を使う。不正ならERROR_
+     * @param entry ログエントリ
+     * @param color true: ANSI版, false: タグ除去版
+     * @param body 本文の格納先
+     * @return 出力するレベル
      */
-    void format_level_padding(const char* level_str, char* output,
-                              int target_width = 8) {
-        char bracketed[32];
-        snprintf(bracketed, sizeof(bracketed), "[%s]", level_str);
-        Utils::StringUtils::apply_padding(bracketed, target_width, output);
+    LogLevel resolve_level(const LogEntry& entry, bool color, Body& body) {
+        if (entry.runtime_tags) {
+            body.staged = true;
+            body.invalid = !Utils::TagScanner::scan(
+                color ? entry.message : entry.plain_message, body.text,
+                static_cast<int>(sizeof(body.text)),
+                color ? Utils::TagScanner::ANSI : Utils::TagScanner::STRIP,
+                &body.len);
+        }
+        return body.invalid ? LogLevel::ERROR_ : entry.level;
     }
 
     /**
-     * @brief ファイル名:行番号をパディング
-     * @param filename ファイル名
-     * @param line 行番号
-     * @param output 出力バッファ（target_width+1以上のサイズが必要）
-     * @param target_width 目標幅（デフォルト15）
+     * @brief メッセージ本文を出力先へ追加
+     * @param line 出力先
+     * @param entry ログエントリ
+     * @param color true: ANSI版, false: タグ除去版
+     * @param body resolve_levelで処理した本文
      */
-    void format_location_padding(const char* filename, int line, char* output,
-                                 int target_width = 15) {
-        char location[64];
-        snprintf(location, sizeof(location), "%s:%d", filename, line);
-        Utils::StringUtils::apply_padding(location, target_width, output, true);
+    void append_message(Utils::LineBuilder& line, const LogEntry& entry,
+                        bool color, const Body& body) {
+        if (body.invalid) {
+            line.append("Invalid color tags");
+        } else if (body.staged) {
+            line.append(body.text, body.len);
+        } else {
+            line.append(color ? entry.message : entry.plain_message);
+        }
     }
 
-    LogInfo get_LogInfo(const LogEntry& entry) {
-        const char* level_str =
-            Utils::StringUtils::get_level_string(entry.level);
+    LogInfo get_LogInfo(const LogEntry& entry, LogLevel level) {
+        const char* level_str = Utils::StringUtils::get_level_string(level);
         const char* filename =
             Utils::StringUtils::extract_filename(entry.filename);
         return {level_str, filename};
@@ -86,38 +126,67 @@ class ConsoleFmt : public FormatterBase {
     /**
      * @brief コンストラクタ
      * @param enable_color カラー出力を有効にするか
+     * @param time 行頭に付ける時刻の精度（既定は付けない）
      */
-    explicit ConsoleFmt(bool enable_color = true)
-        : color_enabled(enable_color) {}
+    explicit ConsoleFmt(bool enable_color = true,
+                        Time::Precision time = Time::Precision::NONE)
+        : color_enabled(enable_color) {
+        time_precision = time;
+    }
+
+    bool uses_color() const override { return color_enabled; }
 
     /**
      * @brief ログエントリをコンソール形式でフォーマット
-     * @param entry ログエントリ（formatedMsgバッファに出力される）
+     * @details 出力先へヘッダと本文を1パスで書き込む（printf系は使わない）
      */
-    void format(const LogEntry& entry) override {
-        // Utils::ColorHelperとUtils::StringUtilsを使用して統一処理
-        LogInfo info = this->get_LogInfo(entry);
-
-        const char* color = ColorMap::LEVEL_COLORS.at(entry.level);
-        const char* reset = ColorMap::RESET;
-
-        // カラーメッセージを解析（統一処理を使用）
-        char colored_msg[256];
-        Utils::ColorHelper::parse_color_tags(entry.message, colored_msg,
-                                             sizeof(colored_msg));
+    size_t format(const LogEntry& entry, char* out, size_t size) override {
+        Body body;
+        LogLevel level = resolve_level(entry, color_enabled, body);
+        Utils::LineBuilder line(out, size);
+        const char* color =
+            Utils::ColorHelper::get_level_color(level, color_enabled);
+        const char* reset = Utils::ColorHelper::get_reset_color(color_enabled);
+        Time::append(line, entry.timestamp, time_precision);
+
+        // マクロ経由なら描画済みのヘッダをコピーするだけ
+        const CallSite* site = entry.site;
+        if (site != nullptr && level == site->level) {
+            if (color_enabled) {
+                line.append(color);
+                line.append(site->header, site->level_len);
+                line.append(reset);
+                line.append(site->header + site->level_len,
+                            site->header_len - site->level_len);
+            } else {
+                line.append(site->header, site->header_len);
+            }
+            append_message(line, entry, color_enabled, body);
+            return line.size();
+        }
 
         // レベル部分をパディング（8文字固定）
-        char level_padded[16];
-        const int level_padding = 8 - strlen(info.level_str) - 2;
-        snprintf(level_padded, sizeof(level_padded), "[%s]%-*s", info.level_str,
-                 level_padding, "");
+        LogInfo info = this->get_LogInfo(entry, level);
+        const size_t level_len = strlen(info.level_str);
+        line.append(color);
+        line.append('[');
+        line.append(info.level_str, level_len);
+        line.append(']');
+        line.fill(' ', 8 - static_cast<int>(level_len) - 2);
+        line.append(reset);
 
         // 最終フォーマット: [LEVEL]   filename:line        : message
-        const int line_width = snprintf(nullptr, 0, "%d", entry.line);
-        const int padding = 13 - strlen(info.filename) - line_width;
-        Utils::StringUtils::log_sprintf(entry, "%s%s%s %s:%d%*s : %s", color,
-                                        level_padded, reset, info.filename,
-                                        entry.line, padding, "", colored_msg);
+        const size_t name_len = strlen(info.filename);
+        line.append(' ');
+        line.append(info.filename, name_len);
+        line.append(':');
+        const size_t line_width =
+            line.append_uint(static_cast<unsigned>(entry.line));
+        line.fill(' ', 13 - static_cast<int>(name_len + line_width));
+        line.append(" : ", 3);
+
+        append_message(line, entry, color_enabled, body);
+        return line.size();
     }
 };
 
@@ -127,22 +196,44 @@ class ConsoleFmt : public FormatterBase {
  */
 class PlainFmt : public FormatterBase {
    public:
+    /**
+     * @brief コンストラクタ
+     * @param time 行頭に付ける時刻の精度（既定は付けない）
+     */
+    explicit PlainFmt(Time::Precision time = Time::Precision::NONE) {
+        time_precision = time;
+    }
+
     /**
      * @brief ログエントリをプレーンテキスト形式でフォーマット
-     * @param entry ログエントリ（formatedMsgバッファに出力される）
      */
-    void format(const LogEntry& entry) override {
-        LogInfo info = this->get_LogInfo(entry);
+    size_t format(const LogEntry& entry, char* out, size_t size) override {
+        Body body;
+        LogLevel level = resolve_level(entry, false, body);
+        Utils::LineBuilder line(out, size);
+        Time::append(line, entry.timestamp, time_precision);
+
+        // マクロ経由なら描画済みのヘッダをコピーするだけ
+        const CallSite* site = entry.site;
+        if (site != nullptr && level == site->level) {
+            line.append(site->brief, site->brief_len);
+            append_message(line, entry, false, body);
+            return line.size();
+        }
+
+        // シンプルなフォーマット: [LEVEL] filename:line : message
+        LogInfo info = this->get_LogInfo(entry, level);
+        line.append('[');
+        line.append(info.level_str);
+        line.append("] ", 2);
+        line.append(info.filename);
+        line.append(':');
+        line.append_uint(static_cast<unsigned>(entry.line));
+        line.append(" : ", 3);
 
         // プレーンテキストではカラータグを除去
-        char plain_message[256];
-        Utils::ColorHelper::strip_color_tags(entry.message, plain_message,
-                                             sizeof(plain_message));
-
-        // シンプルなフォーマット
-        Utils::StringUtils::log_sprintf(entry, "[%s] %s:%d : %s",
-                                        info.level_str, info.filename,
-                                        entry.line, plain_message);
+        append_message(line, entry, false, body);
+        return line.size();
     }
 };
 
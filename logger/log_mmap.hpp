@@ -0,0 +1,514 @@
+/**
+ * @file log_mmap.hpp
+ * @brief メモリマップしたセグメントファイルへの出力
+ * @details 事前確保したファイルをmmapし、レコードをmemcpyで追記する
+ * （出力毎のシステムコールなし）。レコードは長さとCRC32で枠付けし、
+ * プロセスがクラッシュしても完全なレコードを全て読み戻せる
+ * @author ren255
+ */
+
+#ifndef LOG_MMAP_HPP
+#define LOG_MMAP_HPP
+
+#include <atomic>              // ロックフリー同期（std::atomic）
+#include <condition_variable>  // 準備スレッドへの通知
+#include <cstdint>             // uint32_t
+#include <mutex>               // 準備スレッドとの受け渡し
+#include <string>              // セグメントのファイル名
+#include <thread>              // 準備スレッド、std::this_thread::yield
+#include <errno.h>     // EEXIST
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // ftruncate, close
+
+namespace logger {
+/**
+ * @brief セグメントファイルの形式と検証を提供する名前空間
+ * @details ファイルはSegmentHeaderに続いて8バイト境界のレコードが並ぶ。
+ * 各レコードはRecordHeaderと1行分のテキスト（改行なし）
+ */
+namespace Segment {
+
+constexpr char FILE_MAGIC[8] = {'C', 'L', 'O', 'G', 'S', 'E', 'G', '1'};
+constexpr uint32_t RECORD_MAGIC = 0x52474F4C;  // "LOGR"
+
+/**
+ * @brief セグメント先頭のヘッダ
+ */
+struct SegmentHeader {
+    char magic[8];   ///< FILE_MAGIC
+    uint32_t index;  ///< セグメント番号
+    uint32_t reserved;
+};
+
+/**
+ * @brief レコードのヘッダ
+ */
+struct RecordHeader {
+    uint32_t magic;  ///< RECORD_MAGIC（最後に書く）
+    uint32_t crc;    ///< len, levelとテキストのCRC32
+    uint16_t len;    ///< テキストのバイト数
+    uint8_t level;   ///< LogLevel
+    uint8_t pad;
+};
+
+/**
+ * @brief ヘッダとテキストを含むレコードのバイト数（8バイト境界）
+ */
+constexpr size_t record_size(size_t len) {
+    return (sizeof(RecordHeader) + len + 7) & ~static_cast<size_t>(7);
+}
+
+/**
+ * @brief CRC32の表
+ */
+struct CrcTable {
+    uint32_t value[256];
+};
+
+/**
+ * @brief CRC32（多項式0xEDB88320）の表を構築（コンパイル時）
+ */
+constexpr CrcTable make_crc_table() {
+    CrcTable table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table.value[i] = crc;
+    }
+    return table;
+}
+
+/**
+ * @brief 全翻訳単位で共有するCRC32表
+ */
+template <typename Dummy = void>
+struct Tables {
+    static constexpr CrcTable CRC = make_crc_table();
+};
+template <typename Dummy>
+constexpr CrcTable Tables<Dummy>::CRC;
+
+/**
+ * @brief レコードのCRC32を計算
+ * @param len テキストのバイト数
+ * @param level ログレベル
+ * @param text テキスト
+ */
+inline uint32_t record_crc(uint16_t len, uint8_t level, const char* text) {
+    uint32_t crc = 0xFFFFFFFFu;
+    const uint8_t head[3] = {static_cast<uint8_t>(len & 0xFF),
+                             static_cast<uint8_t>(len >> 8), level};
+    for (uint8_t byte : head) {
+        crc = Tables<>::CRC.value[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        crc = Tables<>::CRC.value[(crc ^ static_cast<uint8_t>(text[i])) &
+                                  0xFF] ^
+              (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief セグメントの走査結果
+ */
+struct ScanResult {
+    bool header_ok = false;  ///< SegmentHeaderが正しい
+    uint32_t index = 0;      ///< セグメント番号
+    size_t records = 0;      ///< 完全なレコード数
+    size_t valid_end = 0;    ///< 最後の完全なレコードの終端
+    size_t damaged = 0;      ///< valid_endより前の壊れたバイト数
+};
+
+/**
+ * @brief セグメントの内容を検証しながら走査
+ * @details 壊れたレコード（書き込み途中でクラッシュしたもの）は8バイト
+ * ずつ進めて次の正しいヘッダを探し、後続の完全なレコードも拾う
+ * @param on_record 完全なレコード毎に呼ばれる(const RecordHeader&, const char*)
+ */
+template <typename F>
+ScanResult scan(const char* data, size_t size, F&& on_record) {
+    ScanResult result;
+    if (size < sizeof(SegmentHeader) ||
+        memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        return result;
+    }
+    SegmentHeader header;
+    memcpy(&header, data, sizeof(header));
+    result.header_ok = true;
+    result.index = header.index;
+
+    size_t pos = sizeof(SegmentHeader);
+    result.valid_end = pos;
+    size_t skipped = 0;
+    while (pos + sizeof(RecordHeader) <= size) {
+        RecordHeader rec;
+        memcpy(&rec, data + pos, sizeof(rec));
+        const char* text = data + pos + sizeof(RecordHeader);
+        if (rec.magic == RECORD_MAGIC && pos + record_size(rec.len) <= size &&
+            rec.crc == record_crc(rec.len, rec.level, text)) {
+            on_record(rec, text);
+            result.records++;
+            result.damaged += skipped;
+            skipped = 0;
+            pos += record_size(rec.len);
+            result.valid_end = pos;
+        } else {
+            skipped += 8;
+            pos += 8;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief セグメントファイルを検証し、必要なら壊れた末尾を切り詰める
+ * @param path セグメントファイル
+ * @param truncate trueなら最後の完全なレコードの後ろを切り詰める
+ * @param on_record 完全なレコード毎に呼ばれる
+ * @return 走査結果（開けない場合header_ok == false）
+ */
+template <typename F>
+ScanResult recover(const char* path, bool truncate, F&& on_record) {
+    ScanResult result;
+    int fd = ::open(path, truncate ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        return result;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t size = static_cast<size_t>(st.st_size);
+        void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            result = scan(static_cast<const char*>(map), size, on_record);
+            munmap(map, size);
+            if (truncate && result.header_ok && result.valid_end < size) {
+                if (ftruncate(fd, static_cast<off_t>(result.valid_end)) != 0) {
+                    result.header_ok = false;
+                }
+            }
+        }
+    }
+    ::close(fd);
+    return result;
+}
+
+}  // namespace Segment
+
+namespace Writers {
+
+/**
+ * @brief メモリマップしたセグメントへの出力クラス
+ * @details "<base>.<6桁の番号>.seg"をLOG_SEGMENT_SIZEで事前確保してmmapし、
+ * レコードを枠付けしてmemcpyで追記する。位置の確保はfetch_addで行い、
+ * 複数スレッドから同時に書ける（ロックなし）。次のセグメントは準備スレッドが
+ * 先に作成・確保・mmapしておき、セグメントが埋まったら溢れさせたスレッドは
+ * 書き込み先を差し替えるだけ。前のセグメントは準備スレッドが書き込み中の
+ * レコードの完了を待ってから使用分に切り詰めて閉じる。
+ * 既存のセグメントは上書きせず、空いている番号から作る
+ */
+class MmapWriter : public IWriter {
+   private:
+    // 書き込むスレッドでページフォルトが起きないよう、準備時に割り当てる
+#if defined(MAP_POPULATE)
+    static constexpr int MAP_PREFAULT = MAP_SHARED | MAP_POPULATE;
+#else
+    static constexpr int MAP_PREFAULT = MAP_SHARED;
+#endif
+    // セグメントを封印した印（これ以降の確保は必ず容量を超える）
+    static constexpr size_t SEALED = static_cast<size_t>(-1) / 2;
+
+    // 計数が他方のセグメントの計数と同じキャッシュラインに載らないよう
+    // パディングで離す
+    struct Slot {
+        std::atomic<size_t> reserved{SEALED};  // 確保済みバイト数
+        std::atomic<size_t> committed{0};  // 書き込み完了バイト数（ヘッダ込み）
+        size_t used = 0;                       // 封印時点の確保済みバイト数
+        char* map = nullptr;  // mmapした先頭（開けなかった場合nullptr）
+        int fd = -1;
+        std::string path;
+        char pad[64];
+    };
+
+    const std::string base;
+    const size_t segment_size;
+    uint32_t next_index = 0;  // 次に試すセグメント番号（準備スレッドのみ）
+
+    Slot slots[2];
+    // 書き込み中のセグメントの世代（偶奇がスロット）
+    std::atomic<size_t> generation{0};
+    std::atomic<size_t> prepared{0};  // スロットを開き終えた最新の世代
+
+    std::thread preparer;
+    std::mutex prepare_mutex;
+    std::condition_variable prepare_cv;
+    size_t prepare_request = 0;  // 用意する世代（preparedより大きければ依頼）
+    bool stopping = false;
+
+    /**
+     * @brief 空いている番号でセグメントを作成してmmap
+     * @details 開けない場合はmapをnullptrにする（以降のレコードは捨てる）
+     */
+    void open_segment(Slot& slot) {
+        slot.map = nullptr;
+        slot.fd = -1;
+        for (int tries = 0; tries < 100000; tries++) {
+            char suffix[24];
+            snprintf(suffix, sizeof(suffix), ".%06u.seg", next_index);
+            std::string path = base + suffix;
+            uint32_t index = next_index++;
+            int fd = ::open(path.c_str(),
+                            O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                if (errno == EEXIST) {
+                    continue;
+                }
+                break;
+            }
+            // 書き込み時のSIGBUSを避けるため、領域は先に確保する
+#if defined(__APPLE__)
+            bool allocated =
+                ftruncate(fd, static_cast<off_t>(segment_size)) == 0;
+#else
+            bool allocated =
+                posix_fallocate(fd, 0, static_cast<off_t>(segment_size)) == 0;
+#endif
+            void* map = allocated ? mmap(nullptr, segment_size,
+                                         PROT_READ | PROT_WRITE, MAP_PREFAULT,
+                                         fd, 0)
+                                  : MAP_FAILED;
+            if (map == MAP_FAILED) {
+                ::close(fd);
+                ::unlink(path.c_str());
+                printf("[ERROR_] セグメントを確保できません: %s\r\n",
+                       path.c_str());
+                return;
+            }
+            Segment::SegmentHeader header = {{}, index, 0};
+            memcpy(header.magic, Segment::FILE_MAGIC, sizeof(header.magic));
+            memcpy(map, &header, sizeof(header));
+            slot.map = static_cast<char*>(map);
+            slot.fd = fd;
+            slot.path = path;
+            return;
+        }
+        printf("[ERROR_] セグメントを作成できません: %s\r\n", base.c_str());
+    }
+
+    /**
+     * @brief 書き込み完了を待ち、使用分に切り詰めて閉じる
+     */
+    void close_segment(Slot& slot) {
+        while (slot.committed.load(std::memory_order_acquire) != slot.used) {
+            std::this_thread::yield();
+        }
+        if (slot.map != nullptr) {
+            munmap(slot.map, segment_size);
+            if (ftruncate(slot.fd, static_cast<off_t>(slot.used)) != 0) {
+                // 切り詰めに失敗しても末尾は0埋めで、走査は正しく終わる
+            }
+            ::close(slot.fd);
+            slot.map = nullptr;
+            slot.fd = -1;
+        }
+    }
+
+    /**
+     * @brief 準備スレッド
+     * @details 差し替えられたスロットの前のセグメントを閉じ、同じスロットへ
+     * 次の次のセグメントを開いておく（確保とmmapは書き込むスレッドで行わない）
+     */
+    void prepare_loop() {
+        std::unique_lock<std::mutex> lock(prepare_mutex);
+        while (true) {
+            prepare_cv.wait(lock, [this] {
+                return stopping ||
+                       prepare_request >
+                           prepared.load(std::memory_order_relaxed);
+            });
+            size_t gen = prepare_request;
+            if (gen <= prepared.load(std::memory_order_relaxed)) {
+                return;  // stopping（依頼は全て済んでいる）
+            }
+            lock.unlock();
+            Slot& slot = slots[gen & 1];
+            close_segment(slot);
+            open_segment(slot);
+            prepared.store(gen, std::memory_order_release);
+            lock.lock();
+        }
+    }
+
+    /**
+     * @brief 封印したセグメントから次のセグメントへ切り替える
+     * @details 封印したスレッドは世代毎に1つだけなので、世代の更新は
+     * 競合しない。次のセグメントは準備スレッドが開いてあるので、ここでは
+     * 計数を戻して世代を進め、前のセグメントの片付けを依頼するだけ
+     * @param index 封印したスロット
+     * @param used 封印時点の確保済みバイト数
+     */
+    void rollover(int index, size_t used) {
+        // 古い世代を読んだスレッドが封印した場合は、そのスロットが
+        // 書き込み先になるまで待つ（直前の切り替えの途中）
+        size_t gen = generation.load(std::memory_order_acquire);
+        while (static_cast<int>(gen & 1) != index) {
+            std::this_thread::yield();
+            gen = generation.load(std::memory_order_acquire);
+        }
+        Slot& slot = slots[index];
+        slot.used = used;
+
+        // 準備スレッドが間に合っていない場合だけ待つ
+        while (prepared.load(std::memory_order_acquire) < gen + 1) {
+            std::this_thread::yield();
+        }
+        Slot& next = slots[index ^ 1];
+        next.committed.store(sizeof(Segment::SegmentHeader),
+                             std::memory_order_relaxed);
+        next.reserved.store(sizeof(Segment::SegmentHeader),
+                            std::memory_order_release);
+        generation.store(gen + 1, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(prepare_mutex);
+            prepare_request = gen + 2;
+        }
+        prepare_cv.notify_one();
+    }
+
+    /**
+     * @brief レコードを枠付けして追記
+     * @param level ログレベル
+     * @param text 1行（改行なし）
+     * @param len 行の長さ
+     */
+    void append(LogLevel level, const char* text, size_t len) {
+        if (len > LOG_FMT_SIZE) {
+            len = LOG_FMT_SIZE;
+        }
+        const size_t total = Segment::record_size(len);
+        for (;;) {
+            size_t gen = generation.load(std::memory_order_acquire);
+            int index = static_cast<int>(gen & 1);
+            Slot& slot = slots[index];
+            size_t offset =
+                slot.reserved.fetch_add(total, std::memory_order_acq_rel);
+            if (offset + total <= segment_size) {
+                if (slot.map != nullptr) {
+                    write_record(slot.map + offset, level, text, len);
+                }
+                slot.committed.fetch_add(total, std::memory_order_release);
+                return;
+            }
+            if (offset <= segment_size) {
+                // 最初に溢れさせたスレッドが切り替えを担当
+                rollover(index, offset);
+            } else {
+                while (generation.load(std::memory_order_acquire) == gen) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief テキスト、ヘッダの順に書く（magicは最後）
+     */
+    static void write_record(char* out, LogLevel level, const char* text,
+                             size_t len) {
+        Segment::RecordHeader rec;
+        rec.len = static_cast<uint16_t>(len);
+        rec.level = static_cast<uint8_t>(level);
+        rec.pad = 0;
+        rec.crc = Segment::record_crc(rec.len, rec.level, text);
+        rec.magic = Segment::RECORD_MAGIC;
+        memcpy(out + sizeof(rec), text, len);
+        memcpy(out + sizeof(rec.magic), &rec.crc,
+               sizeof(rec) - sizeof(rec.magic));
+        memcpy(out, &rec.magic, sizeof(rec.magic));
+    }
+
+   public:
+    /**
+     * @brief コンストラクタ
+     * @param base_path セグメントのファイル名の前半（"<base>.<番号>.seg"）
+     * @param size 1セグメントのバイト数
+     */
+    explicit MmapWriter(const char* base_path, size_t size = LOG_SEGMENT_SIZE)
+        : base(base_path),
+          segment_size(size < 4096 ? 4096 : size) {
+        open_segment(slots[0]);
+        slots[0].committed.store(sizeof(Segment::SegmentHeader),
+                                 std::memory_order_relaxed);
+        slots[0].reserved.store(sizeof(Segment::SegmentHeader),
+                                std::memory_order_relaxed);
+        prepare_request = 1;
+        preparer = std::thread(&MmapWriter::prepare_loop, this);
+    }
+
+    MmapWriter(const MmapWriter&) = delete;
+    MmapWriter& operator=(const MmapWriter&) = delete;
+
+    /**
+     * @brief 書き込み中のセグメントを開けているか
+     */
+    bool is_open() const {
+        return slots[generation.load(std::memory_order_acquire) & 1].map !=
+               nullptr;
+    }
+
+    void write(const LogEntry& entry) override {
+        append(entry.level, entry.formatedMsg, strlen(entry.formatedMsg));
+    }
+
+    /**
+     * @brief 呼び出しスレッド専用のバッファを貸す
+     * @details フォーマッタはここへ1行を組み立て、commitで枠付けして追記する
+     */
+    char* reserve(size_t size) override {
+        return size <= LOG_FMT_SIZE ? Memory::thread_staging() : nullptr;
+    }
+
+    void commit(const LogEntry& entry, size_t len) override {
+        append(entry.level, Memory::thread_staging(), len);
+    }
+
+    /**
+     * @brief 何もしない
+     * @details レコードは書いた時点でページキャッシュにあり、プロセスが
+     * 落ちても失われない
+     */
+    void flush() override {}
+
+    /**
+     * @brief デストラクタ - 使用分に切り詰めて閉じる
+     * @details 準備済みで使わなかったセグメントは消す
+     */
+    ~MmapWriter() override {
+        {
+            std::lock_guard<std::mutex> lock(prepare_mutex);
+            stopping = true;
+        }
+        prepare_cv.notify_one();
+        preparer.join();  // 依頼済みの片付けと準備は終えてから止まる
+        size_t gen = generation.load(std::memory_order_acquire);
+        Slot& slot = slots[gen & 1];
+        slot.used = slot.reserved.load(std::memory_order_acquire);
+        close_segment(slot);
+        Slot& spare = slots[(gen + 1) & 1];
+        if (spare.map != nullptr) {
+            munmap(spare.map, segment_size);
+            ::close(spare.fd);
+            ::unlink(spare.path.c_str());
+        }
+    }
+};
+
+}  // namespace Writers
+}  // namespace logger
+
+#endif  // LOG_MMAP_HPP
@@ -0,0 +1,105 @@
+/**
+ * @file log_pool.hpp
+ * @brief 整形用バッファとメモリ確保ヘルパ
+ * @details 実行時にヒープを使わずフォーマット用バッファを用意する
+ * @author ren255
+ */
+
+#ifndef LOG_POOL_HPP
+#define LOG_POOL_HPP
+
+#include <cstdint>  // uintptr_t
+#include <new>      // placement new
+
+namespace logger {
+/**
+ * @brief メモリ管理を提供する名前空間
+ */
+namespace Memory {
+
+/**
+ * @brief スレッド毎の整形用バッファ
+ * @details キャッシュライン境界に揃え、スレッド間の偽共有を避ける
+ */
+struct alignas(64) StagingBuffer {
+    char data[LOG_FMT_SIZE];
+};
+
+/**
+ * @brief 呼び出しスレッド専用の整形用バッファを取得
+ * @details スレッドローカル領域に置くため、ヒープもロックも使わない。
+ * 枯渇もしないので、スレッド数に関係なくレコードを捨てない
+ * @return LOG_FMT_SIZEバイトのバッファ
+ */
+inline char* thread_staging() {
+    static thread_local StagingBuffer staging;
+    return staging.data;
+}
+
+/**
+ * @brief alignof(T)境界に揃えてTを確保
+ * @details C++14のnewは16Bを超えるアラインメントを保証しないため、
+ * 余分に確保して先頭を揃え、直前に元のポインタを保存する
+ * @return 構築済みのオブジェクト（aligned_deleteで解放）
+ */
+template <typename T>
+T* aligned_new() {
+    const size_t align = alignof(T);
+    char* raw = new char[sizeof(T) + align + sizeof(void*)];
+    uintptr_t addr = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+    addr = (addr + align - 1) & ~(uintptr_t)(align - 1);
+    reinterpret_cast<char**>(addr)[-1] = raw;
+    return new (reinterpret_cast<void*>(addr)) T();
+}
+
+/**
+ * @brief aligned_newで確保したオブジェクトを解放
+ */
+template <typename T>
+void aligned_delete(T* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    char* raw = reinterpret_cast<char**>(ptr)[-1];
+    ptr->~T();
+    delete[] raw;
+}
+
+/**
+ * @brief align境界に揃えたバイト列を確保
+ * @details aligned_newと同じく直前に元のポインタを保存する
+ * @param size バイト数
+ * @param align 境界（2の冪）
+ * @return 先頭（aligned_bytes_deleteで解放）
+ */
+inline char* aligned_bytes(size_t size, size_t align) {
+    char* raw = new char[size + align + sizeof(void*)];
+    uintptr_t addr = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+    addr = (addr + align - 1) & ~(uintptr_t)(align - 1);
+    reinterpret_cast<char**>(addr)[-1] = raw;
+    return reinterpret_cast<char*>(addr);
+}
+
+/**
+ * @brief aligned_bytesで確保したバイト列を解放
+ */
+inline void aligned_bytes_delete(char* ptr) {
+    if (ptr != nullptr) {
+        delete[] reinterpret_cast<char**>(ptr)[-1];
+    }
+}
+
+/**
+ * @brief aligned_new用のunique_ptrデリータ
+ */
+struct AlignedDeleter {
+    template <typename T>
+    void operator()(T* ptr) const {
+        aligned_delete(ptr);
+    }
+};
+
+}  // namespace Memory
+}  // namespace logger
+
+#endif  // LOG_POOL_HPP
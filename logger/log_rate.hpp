@@ -0,0 +1,110 @@
+/**
+ * @file log_rate.hpp
+ * @brief 呼び出し箇所毎の間引き・回数制限
+ * @details LOG_*_EVERY_N などのマクロが呼び出し箇所毎にstaticで持つ状態。
+ * 判定はフォーマットより前に行い、捨てる場合はrelaxedのアトミック操作
+ * 1回で終わる（vsnprintfも色タグの検証も行わない）
+ * @author ren255
+ */
+
+#ifndef LOG_RATE_HPP
+#define LOG_RATE_HPP
+
+#include <atomic>   // ロックフリー同期（std::atomic）
+#include <cstdint>  // uint64_t
+
+namespace logger {
+/**
+ * @brief 間引き・回数制限を提供する名前空間
+ * @details 各クラスはconstexprで0初期化できるので、関数内staticでも
+ * 初期化ガードを伴わない
+ */
+namespace RateLimit {
+
+/**
+ * @brief n回に1回だけ通す（1回目, n+1回目, ...）
+ */
+class EveryN {
+   private:
+    std::atomic<uint64_t> count{0};
+
+   public:
+    bool allow(uint64_t n) {
+        const uint64_t seen = count.fetch_add(1, std::memory_order_relaxed);
+        return n <= 1 || seen % n == 0;
+    }
+};
+
+/**
+ * @brief 最初のn回だけ通す
+ * @details 上限に達した後は読み込み1回で捨てる（カウンタも進めない）
+ */
+class FirstN {
+   private:
+    std::atomic<uint64_t> count{0};
+
+   public:
+    bool allow(uint64_t n) {
+        if (count.load(std::memory_order_relaxed) >= n) {
+            return false;
+        }
+        return count.fetch_add(1, std::memory_order_relaxed) < n;
+    }
+};
+
+/**
+ * @brief ms毎に1回だけ通す
+ * @details 次に通してよい時刻を持ち、それより前なら捨てる。同時に
+ * 時刻を過ぎた呼び出しのうちCASに勝った1つだけが通る
+ */
+class EveryMs {
+   private:
+    std::atomic<timestamp_t> next{0};
+
+   public:
+    bool allow(uint64_t ms) {
+        const timestamp_t now = Time::now();
+        timestamp_t expected = next.load(std::memory_order_relaxed);
+        if (now < expected) {
+            return false;
+        }
+        return next.compare_exchange_strong(expected, now + ms * 1000000,
+                                            std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief トークンバケット（毎秒rate個、最大burst個まで溜まる）
+ * @details GCRA方式: トークン数の代わりに「バケットが空になる理論時刻」
+ * 1語だけを持つので、残量と時刻を別々に更新する競合が起きない
+ */
+class TokenBucket {
+   private:
+    std::atomic<timestamp_t> tat{0};  // 理論到着時刻
+
+   public:
+    bool allow(uint64_t rate, uint64_t burst) {
+        if (rate == 0) {
+            return false;
+        }
+        const timestamp_t now = Time::now();
+        const timestamp_t interval = 1000000000 / rate;
+        const timestamp_t window = interval * (burst == 0 ? 1 : burst);
+        timestamp_t current = tat.load(std::memory_order_relaxed);
+        for (;;) {
+            const timestamp_t start = current > now ? current : now;
+            if (start + interval - now > window) {
+                return false;  // バケットが空
+            }
+            if (tat.compare_exchange_weak(current, start + interval,
+                                          std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+};
+
+}  // namespace RateLimit
+}  // namespace logger
+
+#endif  // LOG_RATE_HPP
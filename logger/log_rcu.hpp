@@ -0,0 +1,195 @@
+/**
+ * @file log_rcu.hpp
+ * @brief 読み手をロックしない設定の差し替え（RCU）
+ * @details 読み手は自スレッドのスロットに「読んでいる世代」を書いてから
+ * 共有ポインタを読み、終わったら0に戻すだけ。書き手は新しいオブジェクトを
+ * 公開して世代を進め、古い世代を読んでいるスロットが無くなるまで待って
+ * （猶予期間）から古いオブジェクトを解放する。
+ * LOG_MEMBARRIERでは、スロットへの書き込みと共有ポインタの読み込みの間の
+ * フェンスを省き、代わりに書き手がmembarrierで全スレッドにフェンスを
+ * 実行させる（読み手はコンパイラの並べ替えを止めるだけ）
+ * @author ren255
+ */
+
+#ifndef LOG_RCU_HPP
+#define LOG_RCU_HPP
+
+#include <atomic>   // ロックフリー同期（std::atomic）
+#include <cstdint>  // uint64_t
+#include <thread>   // std::this_thread::yield
+
+#if LOG_MEMBARRIER
+#include <linux/membarrier.h>  // MEMBARRIER_CMD_*
+#include <sys/syscall.h>       // __NR_membarrier
+#include <unistd.h>            // syscall
+#endif
+
+namespace logger {
+/**
+ * @brief 読み手をロックしない差し替えを提供する名前空間
+ */
+namespace Rcu {
+
+/**
+ * @brief 読み手のスロット
+ * @details キャッシュライン境界に揃え、スレッド間の偽共有を避ける
+ */
+struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{0};  ///< 読んでいる世代（0なら読んでいない）
+    std::atomic<bool> used{false};   ///< スレッドに割り当て済み
+};
+
+/**
+ * @brief 世代とスロットの表（プロセスで1つ）
+ */
+struct Domain {
+    std::atomic<uint64_t> epoch{1};  // 現在の世代
+    bool asymmetric = false;         // membarrierを登録できた
+    Slot slots[LOG_RCU_SLOTS];
+    alignas(64) std::atomic<long> shared{0};  // スロットを持てなかった読み手の数
+
+    Domain() {
+#if LOG_MEMBARRIER
+        asymmetric = syscall(__NR_membarrier,
+                             MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0,
+                             0) == 0;
+#endif
+    }
+};
+
+inline Domain& domain() {
+    static Domain instance;
+    return instance;
+}
+
+/**
+ * @brief スレッド毎の状態（自明に初期化でき、参照に初期化ガードが付かない）
+ */
+struct ThreadState {
+    Slot* slot;    // 割り当てたスロット（無ければnullptr）
+    bool claimed;  // 割り当てを試みた
+};
+
+inline ThreadState& thread_state() {
+    static thread_local ThreadState state{nullptr, false};
+    return state;
+}
+
+/**
+ * @brief スロットの割り当てと、スレッド終了時の返却
+ */
+struct ThreadSlot {
+    Slot* slot = nullptr;  // 表が満杯ならnullptr
+
+    ThreadSlot() {
+        for (Slot& candidate : domain().slots) {
+            bool expected = false;
+            if (!candidate.used.load(std::memory_order_relaxed) &&
+                candidate.used.compare_exchange_strong(
+                    expected, true, std::memory_order_acquire)) {
+                slot = &candidate;
+                break;
+            }
+        }
+        thread_state().slot = slot;
+    }
+
+    ~ThreadSlot() {
+        // 以降（他のthread_localの破棄中）は共有カウンタで数える
+        thread_state().slot = nullptr;
+        if (slot != nullptr) {
+            slot->epoch.store(0, std::memory_order_release);
+            slot->used.store(false, std::memory_order_release);
+        }
+    }
+};
+
+/**
+ * @brief 呼び出しスレッドのスロット（初回だけ割り当てる）
+ */
+inline Slot* thread_slot() {
+    ThreadState& state = thread_state();
+    if (!state.claimed) {
+        state.claimed = true;
+        static thread_local ThreadSlot owner;
+        (void)owner;
+    }
+    return state.slot;
+}
+
+/**
+ * @brief 読み取り区間
+ * @details 生存中に読んだ共有ポインタは、書き手に解放されない。
+ * 入れ子にできる（外側の区間が続く）。スロットを持てないスレッドは
+ * 共有のカウンタで数える
+ */
+class ReadGuard {
+   private:
+    Slot* slot;
+    bool outer;  // 最も外側の区間
+
+   public:
+    ReadGuard() : slot(thread_slot()), outer(true) {
+        Domain& d = domain();
+        if (slot == nullptr) {
+            d.shared.fetch_add(1, std::memory_order_seq_cst);
+            return;
+        }
+        if (slot->epoch.load(std::memory_order_relaxed) != 0) {
+            outer = false;
+            return;
+        }
+        const uint64_t epoch = d.epoch.load(std::memory_order_relaxed);
+        if (d.asymmetric) {
+            // フェンスは書き手のmembarrierが代わりに実行させる
+            slot->epoch.store(epoch, std::memory_order_relaxed);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            // この後の共有ポインタの読み込みより前に見えるようseq_cstで書く
+            slot->epoch.store(epoch, std::memory_order_seq_cst);
+        }
+    }
+
+    ~ReadGuard() {
+        if (slot == nullptr) {
+            domain().shared.fetch_sub(1, std::memory_order_release);
+        } else if (outer) {
+            slot->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+};
+
+/**
+ * @brief 猶予期間を待つ（書き手）
+ * @details 呼ぶ前に公開した新しいポインタは、この後に始まる読み取り区間
+ * からしか見えない。戻った時点で、それより前の区間は全て終わっている。
+ * 読み取り区間の中から呼ぶと自分を待ち続けるので呼ばないこと
+ */
+inline void synchronize() {
+    Domain& d = domain();
+    const uint64_t next = d.epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+#if LOG_MEMBARRIER
+    if (d.asymmetric) {
+        // 実行中の全スレッドにフェンスを実行させ、スロットへの書き込みを見せる
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+    }
+#endif
+    for (Slot& slot : d.slots) {
+        uint64_t seen = slot.epoch.load(std::memory_order_seq_cst);
+        while (seen != 0 && seen < next) {
+            std::this_thread::yield();
+            seen = slot.epoch.load(std::memory_order_seq_cst);
+        }
+    }
+    while (d.shared.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+}  // namespace Rcu
+}  // namespace logger
+
+#endif  // LOG_RCU_HPP
@@ -0,0 +1,236 @@
+/**
+ * @file log_sites.hpp
+ * @brief 呼び出し箇所毎の有効・無効スイッチ
+ * @details LOG_*マクロの展開毎に呼び出し箇所のレコード（ファイル・行・
+ * レベル・フォーマットと1バイトのスイッチ）を置き、実行中に個別に
+ * 有効・無効を切り替えられるようにする（Linuxのdynamic debugと同じ考え方）。
+ * レコードは定数で初期化し、最初に実行されたときに（スイッチの読み込みで
+ * 未登録の印を見て）一覧へ繋ぐ。それまでに適用された指示もその時に反映する
+ * ので、まだ実行されていない呼び出し箇所も指定できる
+ * @author ren255
+ */
+
+#ifndef LOG_SITES_HPP
+#define LOG_SITES_HPP
+
+#include <atomic>   // ロックフリー同期（std::atomic）
+#include <cstdint>  // uint8_t
+#include <cstdio>   // FILE, fopen, fgets
+#include <cstdlib>  // atoi
+#include <cstring>  // strcmp
+#include <mutex>    // 登録・指示の排他（std::mutex）
+#include <string>   // 指示のファイル名
+#include <vector>   // 指示の一覧
+
+namespace logger {
+/**
+ * @brief 呼び出し箇所のスイッチを提供する名前空間
+ */
+namespace Sites {
+
+/**
+ * @brief スイッチの状態
+ */
+enum Mode : uint8_t {
+    FOLLOW = 0,  ///< レベル（Loggerかチャネル）に従う（既定）
+    ON = 1,      ///< レベルに関わらず出力
+    OFF = 2,     ///< 出力しない
+};
+
+/// まだ一覧へ繋いでいない印（Modeに重ねる。マクロが置くレコードの初期値）
+constexpr uint8_t UNLINKED = 0x80;
+
+/**
+ * @brief 呼び出し箇所のレコード
+ * @details 定数で初期化できる形にする（初期化ガードを持たない）
+ */
+struct Site {
+    const CallSite* site;       ///< ファイル・行・レベル
+    const char* format;         ///< 元のフォーマット文字列
+    std::atomic<uint8_t> mode;  ///< Mode（一覧へ繋ぐまではUNLINKED付き）
+    Site* next;                 ///< 一覧の次（登録順の逆）
+};
+
+inline bool link(Site& site);
+
+/**
+ * @brief マクロの判定
+ * @details スイッチを1回読むだけ。FOLLOW以外（ON・OFF、未登録）の場合だけ
+ * 比べ直し、未登録なら一覧へ繋いでから判定する（呼び出し箇所毎に1回）
+ * @param level_ok レベルによる判定の結果
+ */
+inline bool passes(Site& site, bool level_ok) {
+    uint8_t mode = site.mode.load(std::memory_order_relaxed);
+    if (mode == FOLLOW) {
+        return level_ok;
+    }
+    if ((mode & UNLINKED) != 0) {
+        link(site);
+        mode = site.mode.load(std::memory_order_relaxed);
+    }
+    return mode == FOLLOW ? level_ok : mode == ON;
+}
+
+/**
+ * @brief 適用済みの指示（後から登録される呼び出し箇所にも反映する）
+ */
+struct Rule {
+    std::string file;  ///< ディレクトリを除いたファイル名、"*"なら全て
+    int line;          ///< 行番号、0ならファイル内の全て
+    Mode mode;
+};
+
+/**
+ * @brief 呼び出し箇所の一覧
+ */
+struct Registry {
+    std::atomic<Site*> head{nullptr};  // 最後に登録したレコード
+    std::vector<Rule> rules;           // 適用順
+    std::mutex mutex;                  // 登録と指示の排他
+};
+
+inline Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+inline bool matches(const Site& site, const char* file, int line) {
+    return (strcmp(file, "*") == 0 || strcmp(file, site.site->basename) == 0) &&
+           (line == 0 || line == site.site->line);
+}
+
+/**
+ * @brief レコードを一覧へ繋ぐ（マクロが最初に実行されたときに1回）
+ * @details 適用済みの指示のうち一致するものを順に反映し、UNLINKEDを外す。
+ * 同時に実行された場合は後のスレッドは何もしない
+ * @return 繋いだ場合true
+ */
+inline bool link(Site& site) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    uint8_t mode = site.mode.load(std::memory_order_relaxed);
+    if ((mode & UNLINKED) == 0) {
+        return false;
+    }
+    mode &= static_cast<uint8_t>(~UNLINKED);
+    for (const Rule& rule : r.rules) {
+        if (matches(site, rule.file.c_str(), rule.line)) {
+            mode = rule.mode;
+        }
+    }
+    site.next = r.head.load(std::memory_order_relaxed);
+    site.mode.store(mode, std::memory_order_relaxed);
+    r.head.store(&site, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief 登録済みの全ての呼び出し箇所についてfnを呼ぶ
+ * @details 一覧は繋ぐだけなので、ロック無しで辿れる
+ */
+template <typename Fn>
+void for_each(Fn fn) {
+    for (Site* site = registry().head.load(std::memory_order_acquire);
+         site != nullptr; site = site->next) {
+        fn(*site);
+    }
+}
+
+/**
+ * @brief ファイル名（と行番号）が一致する呼び出し箇所のスイッチを設定
+ * @details 指示は保存し、まだ実行されていない呼び出し箇所にも
+ * 登録時に反映する（同じファイル・行の以前の指示は置き換える）
+ * @param file ディレクトリを除いたファイル名、"*"なら全て
+ * @param line 行番号、0ならファイル内の全て
+ * @return 登録済みで一致した呼び出し箇所の数
+ */
+inline size_t set(const char* file, int line, Mode mode) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto it = r.rules.begin(); it != r.rules.end(); ++it) {
+        if (it->line == line && it->file == file) {
+            r.rules.erase(it);
+            break;
+        }
+    }
+    r.rules.push_back(Rule{file, line, mode});
+    size_t matched = 0;
+    for_each([&](Site& site) {
+        if (matches(site, file, line)) {
+            site.mode.store(mode, std::memory_order_relaxed);
+            matched++;
+        }
+    });
+    return matched;
+}
+
+/**
+ * @brief 1行の指示を適用
+ * @details "<ファイル名>[:<行>] <+|-|=>"の形。+は有効、-は無効、
+ * =はレベルに従う。ファイル名は"*"で全て
+ * @return 登録済みで一致した呼び出し箇所の数、書式が不正なら0
+ */
+inline size_t apply(const char* command) {
+    char file[128];
+    char op;
+    if (sscanf(command, " %127s %c", file, &op) != 2) {
+        return 0;
+    }
+    int line = 0;
+    if (char* colon = strrchr(file, ':')) {
+        *colon = '\0';
+        line = atoi(colon + 1);
+    }
+    switch (op) {
+        case '+':
+            return set(file, line, ON);
+        case '-':
+            return set(file, line, OFF);
+        case '=':
+            return set(file, line, FOLLOW);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief 制御ファイルの各行を適用
+ * @details 空行と'#'で始まる行は読み飛ばす
+ * @return 登録済みで一致した呼び出し箇所の数（ファイルが無ければ0）
+ */
+inline size_t load(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    size_t matched = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        const char* p = line + strspn(line, " \t");
+        if (*p != '#' && *p != '\n' && *p != '\0') {
+            matched += apply(p);
+        }
+    }
+    fclose(file);
+    return matched;
+}
+
+/**
+ * @brief 登録済みの全ての呼び出し箇所と状態を書き出す
+ * @details 1行1箇所: "file:line [LEVEL] <=|+|-> \"format\""
+ */
+inline void dump(FILE* out) {
+    static const char MODE_CHARS[] = {'=', '+', '-'};
+    for_each([&](Site& site) {
+        const uint8_t mode = site.mode.load(std::memory_order_relaxed);
+        fprintf(out, "%s:%d [%s] %c \"%s\"\n", site.site->basename,
+                site.site->line,
+                Utils::StringUtils::get_level_string(site.site->level),
+                mode <= OFF ? MODE_CHARS[mode] : '?', site.format);
+    });
+}
+
+}  // namespace Sites
+}  // namespace logger
+
+#endif  // LOG_SITES_HPP
@@ -0,0 +1,247 @@
+/**
+ * @file log_time.hpp
+ * @brief ログの時刻
+ * @details 時刻はTSC（使えなければsteady_clock）から取り、壁時計へ合わせる
+ * （TSCはLOG_TSC_REANCHOR_MS毎に合わせ直す）。日時の描画は秒が変わった
+ * ときだけ行い、秒未満は数字を足すだけにする
+ * @author ren255
+ */
+
+#ifndef LOG_TIME_HPP
+#define LOG_TIME_HPP
+
+#include <atomic>  // 基準の更新（seqlock）
+#include <chrono>  // steady_clock, system_clock
+#include <ctime>   // localtime_r
+#if LOG_TSC
+#include <cpuid.h>      // __get_cpuid（不変TSCの確認）
+#include <x86intrin.h>  // __rdtsc
+#endif
+
+namespace logger {
+/**
+ * @brief 時刻を提供する名前空間
+ */
+namespace Time {
+
+/**
+ * @brief 描画する秒未満の桁
+ */
+enum class Precision {
+    NONE,     ///< 時刻を描画しない
+    SECONDS,  ///< YYYY-MM-DD HH:MM:SS
+    MILLIS,   ///< 〜.mmm
+    MICROS,   ///< 〜.uuuuuu
+    NANOS,    ///< 〜.nnnnnnnnn
+};
+
+/**
+ * @brief 較正済みの時計
+ * @details 最初の使用時にLOG_TSC_CALIBRATION_USの間だけTSCとsteady_clock
+ * を比べて周期を求め、同時に読んだsystem_clockを基準にする。以降は
+ * rdtscと掛け算だけでUNIX時刻（ns）を返す（システムコールなし）。
+ * 短い較正の誤差で壁時計から離れていくので、基準からLOG_TSC_REANCHOR_MS
+ * 経ったら、その時に呼んだスレッドが基準をsystem_clockへ合わせ直し、
+ * 周期もその間のsteady_clockで求め直す（合わせ直しで時刻はずれの分だけ
+ * 飛ぶ）。不変TSCが無いCPUやx86以外ではsteady_clockに基準のずれを足す
+ */
+class Clock {
+   private:
+    int64_t base_ns;      // 基準時点のUNIX時刻
+    int64_t base_steady;  // 基準時点のsteady_clock（TSCを使わない場合）
+#if LOG_TSC
+    // 基準はseqlockで更新する（奇数なら更新中）。フェンスを使わないよう、
+    // 基準の各値はrelease/acquireで読み書きする（x86では通常の読み書き）
+    mutable std::atomic<uint32_t> seq{0};
+    mutable std::atomic<int64_t> anchor_ns{0};       // 基準時点のUNIX時刻
+    mutable std::atomic<uint64_t> anchor_ticks{0};   // 基準時点のTSC
+    mutable std::atomic<uint64_t> mult{0};           // 1tickのns * 2^32
+    mutable std::atomic<int64_t> anchor_steady{0};   // 基準時点のsteady_clock
+    uint64_t reanchor_ticks = 0;  // 合わせ直すまでのtick数
+    bool use_tsc = false;
+
+    static bool invariant_tsc() {
+        unsigned a, b, c, d;
+        return __get_cpuid(0x80000007, &a, &b, &c, &d) && (d & (1u << 8));
+    }
+
+    /**
+     * @brief 基準をsystem_clockへ合わせ直す
+     * @details 更新できるのは1スレッドだけ。他が更新中なら何もしない
+     * @param s 読んだときのseq（偶数）
+     */
+    void reanchor(uint32_t s) const {
+        if (!seq.compare_exchange_strong(s, s + 1,
+                                         std::memory_order_acquire)) {
+            return;
+        }
+        const int64_t steady = steady_ns();
+        const uint64_t ticks = __rdtsc();
+        const int64_t wall = wall_ns();
+        const uint64_t old_ticks = anchor_ticks.load(std::memory_order_relaxed);
+        const int64_t old_steady =
+            anchor_steady.load(std::memory_order_relaxed);
+        if (ticks > old_ticks && steady > old_steady) {
+            mult.store(static_cast<uint64_t>(
+                           (static_cast<unsigned __int128>(steady - old_steady)
+                            << 32) /
+                           (ticks - old_ticks)),
+                       std::memory_order_release);
+        }
+        anchor_ns.store(wall, std::memory_order_release);
+        anchor_ticks.store(ticks, std::memory_order_release);
+        anchor_steady.store(steady, std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+#endif
+
+    static int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static int64_t wall_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    Clock() : base_ns(wall_ns()), base_steady(steady_ns()) {
+#if LOG_TSC
+        if (!invariant_tsc()) {
+            return;
+        }
+        const int64_t steady0 = steady_ns();
+        const uint64_t ticks0 = __rdtsc();
+        const int64_t wall0 = wall_ns();
+        int64_t steady1;
+        do {
+            steady1 = steady_ns();
+        } while (steady1 - steady0 < LOG_TSC_CALIBRATION_US * 1000);
+        const uint64_t ticks1 = __rdtsc();
+        if (ticks1 <= ticks0) {
+            return;
+        }
+        const uint64_t m = static_cast<uint64_t>(
+            (static_cast<unsigned __int128>(steady1 - steady0) << 32) /
+            (ticks1 - ticks0));
+        if (m == 0) {
+            return;
+        }
+        mult.store(m, std::memory_order_relaxed);
+        anchor_ns.store(wall0, std::memory_order_relaxed);
+        anchor_ticks.store(ticks0, std::memory_order_relaxed);
+        anchor_steady.store(steady0, std::memory_order_relaxed);
+        reanchor_ticks = static_cast<uint64_t>(
+            (static_cast<unsigned __int128>(LOG_TSC_REANCHOR_MS * 1000000)
+             << 32) /
+            m);
+        use_tsc = true;
+#endif
+    }
+
+   public:
+    /**
+     * @brief 全スレッドで共有する時計（初回に較正）
+     */
+    static const Clock& instance() {
+        static const Clock clock;
+        return clock;
+    }
+
+    /**
+     * @brief 現在のUNIX時刻（ns）
+     */
+    timestamp_t now() const {
+#if LOG_TSC
+        if (use_tsc) {
+            for (;;) {
+                const uint32_t s = seq.load(std::memory_order_acquire);
+                const int64_t ns = anchor_ns.load(std::memory_order_acquire);
+                const uint64_t ticks =
+                    anchor_ticks.load(std::memory_order_acquire);
+                const uint64_t m = mult.load(std::memory_order_acquire);
+                if ((s & 1) != 0 || seq.load(std::memory_order_relaxed) != s) {
+                    continue;  // 合わせ直しの途中
+                }
+                const uint64_t elapsed = __rdtsc() - ticks;
+                if (elapsed >= reanchor_ticks) {
+                    reanchor(s);
+                    continue;
+                }
+                return static_cast<timestamp_t>(ns) +
+                       static_cast<timestamp_t>(
+                           (static_cast<unsigned __int128>(elapsed) * m) >>
+                           32);
+            }
+        }
+#endif
+        return static_cast<timestamp_t>(base_ns + (steady_ns() - base_steady));
+    }
+
+    /**
+     * @brief TSCを使っているか
+     */
+    bool uses_tsc() const {
+#if LOG_TSC
+        return use_tsc;
+#else
+        return false;
+#endif
+    }
+};
+
+/**
+ * @brief 現在のUNIX時刻（ns）
+ */
+inline timestamp_t now() { return Clock::instance().now(); }
+
+/**
+ * @brief 時刻を"YYYY-MM-DD HH:MM:SS.fff "の形で追加
+ * @details 日時部分はスレッド毎にキャッシュし、秒が変わったときだけ
+ * localtime_rで描き直す。秒未満は桁数分の数字を書くだけ
+ */
+inline void append(Utils::LineBuilder& line, timestamp_t ns,
+                   Precision precision) {
+    if (precision == Precision::NONE) {
+        return;
+    }
+    struct DateCache {
+        int64_t second = -1;
+        char text[20];  // "YYYY-MM-DD HH:MM:SS"
+    };
+    static thread_local DateCache cache;
+
+    const int64_t second = static_cast<int64_t>(ns / 1000000000);
+    if (second != cache.second) {
+        time_t sec = static_cast<time_t>(second);
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        strftime(cache.text, sizeof(cache.text), "%Y-%m-%d %H:%M:%S", &tm);
+        cache.second = second;
+    }
+    line.append(cache.text, 19);
+
+    static constexpr int DIGITS[] = {0, 0, 3, 6, 9};
+    const int digits = DIGITS[static_cast<int>(precision)];
+    if (digits != 0) {
+        uint32_t fraction = static_cast<uint32_t>(ns % 1000000000);
+        for (int i = digits; i < 9; i++) {
+            fraction /= 10;
+        }
+        char text[10];
+        text[0] = '.';
+        for (int i = digits; i > 0; i--) {
+            text[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        line.append(text, static_cast<size_t>(digits) + 1);
+    }
+    line.append(' ');
+}
+
+}  // namespace Time
+}  // namespace logger
+
+#endif  // LOG_TIME_HPP
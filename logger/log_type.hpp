@@ -1,6 +1,8 @@
 #ifndef LOG_TYPE_HPP
 #define LOG_TYPE_HPP
 
+#include <cstdint>  // uint8_t
+
 // 前方宣言
 namespace logger {
 class Logger;
@@ -19,6 +21,31 @@ enum class LogLevel {
 };
 
 namespace logger {
+/**
+ * @brief 呼び出し箇所の情報
+ * @details LOG_*マクロ毎にコンパイル時に生成する。
+ * ヘッダ部（レベル・ファイル名・行番号とパディング）は描画済みで、
+ * フォーマッタはmemcpyするだけでよい
+ */
+struct CallSite {
+    LogLevel level;         ///< ログレベル
+    const char* basename;   ///< ディレクトリを除いたファイル名
+    int line;               ///< 行番号
+    const char* header;     ///< "[LEVEL]  file:line    : "（ConsoleFmt形式）
+    uint16_t header_len;    ///< headerの長さ
+    uint8_t level_len;      ///< header先頭のレベル欄の長さ（色付け範囲）
+    const char* brief;      ///< "[LEVEL] file:line : "（PlainFmt形式）
+    uint16_t brief_len;     ///< briefの長さ
+};
+
+struct FormatInfo;
+
+namespace Channels {
+struct Channel;
+}  // namespace Channels
+
+typedef uint64_t timestamp_t;  ///< UNIX時刻（ns）
+
 /**
  * @brief ログエントリ構造体
  * @details 単一のログメッセージに関する全情報を格納
@@ -28,10 +55,28 @@ struct LogEntry {
     LogLevel level;        ///< ログレベル
     const char* filename;  ///< ソースファイル名
     int line;              ///< 行番号
-    const char* message;   ///< ログメッセージ
-    char* formatedMsg;
+    const char* message;        ///< ログメッセージ（色タグANSI変換済み）
+    const char* plain_message;  ///< ログメッセージ（色タグ除去済み）
+    bool runtime_tags;  ///< 引数由来の色タグが残っている（実行時解析が必要）
+    char* formatedMsg;  ///< 整形済みの1行（reserveしないwriter用）
+    const CallSite* site;  ///< 呼び出し箇所（マクロ経由でない場合nullptr）
+    const FormatInfo* format;  ///< フォーマット（payloadがある場合のみ）
+    const char* payload;  ///< 引数の生バイト（LOG_DEFERRED、無ければnullptr）
+    uint16_t payload_len;  ///< payloadのバイト数
+    timestamp_t timestamp;  ///< 呼び出し時刻（Time::now）
     // const char* function;  ///< 関数名（将来用）
-    // timestamp_t timestamp; ///< タイムスタンプ（将来実装）
+};
+
+/**
+ * @brief フォーマット文字列情報
+ * @details LOG_*マクロがコンパイル時に色タグを変換した2種類の文字列を持つ
+ */
+struct FormatInfo {
+    const char* ansi;   ///< 色タグをANSIコードに変換済み
+    const char* plain;  ///< 色タグを除去済み
+    bool runtime_tags;  ///< 引数由来の色タグが残りうる（実行時解析が必要）
+    const CallSite* site;  ///< 呼び出し箇所（無い場合nullptr）
+    const Channels::Channel* channel;  ///< LOG_CHのチャネル（無い場合nullptr）
 };
 
 /**
@@ -40,9 +85,9 @@ struct LogEntry {
  */
 namespace ColorMap {
 /**
- * @brief ANSIカラーコードマップ
+ * @brief カラータグとANSIコードの対応（constexpr、コンパイル時変換用）
  */
-static const std::map<char, const char*> ANSI_COLORS = {
+constexpr std::pair<char, const char*> COLOR_CODES[] = {
     // 基本色
     {'r', "\033[31m"},  // Red - 赤
     {'g', "\033[32m"},  // Green - 緑
@@ -69,19 +114,98 @@ static const std::map<char, const char*> ANSI_COLORS = {
 };
 
 /**
- * @brief ログレベル用カラーマップ
+ * @brief カラータグからANSIコードを検索（テーブル構築用）
+ * @param tag カラータグ文字
+ * @return ANSIコード、未定義ならnullptr
+ */
+constexpr const char* find_code(char tag) {
+    for (const auto& color : COLOR_CODES) {
+        if (color.first == tag) {
+            return color.second;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 文字を添字とするANSIコード表
+ */
+struct ColorTable {
+    const char* code[256];  ///< タグ文字 -> ANSIコード（未定義はnullptr）
+    uint8_t length[256];    ///< ANSIコードのバイト数
+};
+
+/**
+ * @brief COLOR_CODESからColorTableを構築（コンパイル時）
+ */
+constexpr ColorTable make_color_table() {
+    ColorTable table{};
+    for (const auto& color : COLOR_CODES) {
+        unsigned char index = static_cast<unsigned char>(color.first);
+        uint8_t len = 0;
+        while (color.second[len] != '\0') {
+            len++;
+        }
+        table.code[index] = color.second;
+        table.length[index] = len;
+    }
+    return table;
+}
+
+/**
+ * @brief 直接添字参照のカラーテーブル群
+ * @details テンプレートの静的メンバにすることで、全翻訳単位で1つの実体を
+ * 共有し、静的初期化も発生しない
  */
-static const std::map<LogLevel, const char*> LEVEL_COLORS = {
-    {LogLevel::DEBUG_, ANSI_COLORS.at('b')},  // Blue
-    {LogLevel::INFO_, ANSI_COLORS.at('g')},   // Green
-    {LogLevel::WARN_, ANSI_COLORS.at('y')},   // Yellow
-    {LogLevel::ERROR_, ANSI_COLORS.at('r')}   // Red
+template <typename Dummy = void>
+struct Tables {
+    static constexpr ColorTable ANSI = make_color_table();
+
+    /// ログレベル -> ANSIコード（LogLevelの並び順）
+    static constexpr const char* LEVEL[4] = {
+        find_code('b'),  // DEBUG_: Blue
+        find_code('g'),  // INFO_:  Green
+        find_code('y'),  // WARN_:  Yellow
+        find_code('r'),  // ERROR_: Red
+    };
 };
+template <typename Dummy>
+constexpr ColorTable Tables<Dummy>::ANSI;
+template <typename Dummy>
+constexpr const char* Tables<Dummy>::LEVEL[4];
+
+/**
+ * @brief カラータグのANSIコードを取得
+ * @param tag カラータグ文字
+ * @return ANSIコード、未定義ならnullptr
+ */
+constexpr const char* ansi_code(char tag) {
+    return Tables<>::ANSI.code[static_cast<unsigned char>(tag)];
+}
+
+/**
+ * @brief カラータグのANSIコード長を取得
+ * @param tag カラータグ文字
+ * @return バイト数、未定義なら0
+ */
+constexpr size_t ansi_length(char tag) {
+    return Tables<>::ANSI.length[static_cast<unsigned char>(tag)];
+}
+
+/**
+ * @brief ログレベルのANSIコードを取得
+ * @param level ログレベル
+ * @return ANSIコード
+ */
+constexpr const char* level_code(LogLevel level) {
+    return Tables<>::LEVEL[static_cast<int>(level)];
+}
 
 /**
  * @brief リセットコード
  */
-static const char* RESET = "\033[0m";
+static constexpr const char* RESET = "\033[0m";
+static constexpr size_t RESET_LEN = 4;  ///< RESETのバイト数
 }  // namespace ColorMap
 
 }  // namespace logger
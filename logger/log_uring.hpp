@@ -0,0 +1,426 @@
+/**
+ * @file log_uring.hpp
+ * @brief io_uringによる非同期ファイル出力
+ * @details 埋まったブロックをio_uringの書き込みとして投入し、カーネルが
+ * 書いている間も次のブロックへ書き続ける。io_uringが使えない環境では
+ * pwriteで同期的に書く
+ * @author ren255
+ */
+
+#ifndef LOG_URING_HPP
+#define LOG_URING_HPP
+
+#include <cstdint>             // uint64_t
+#include <errno.h>             // EINTR
+#include <fcntl.h>             // open
+#include <linux/io_uring.h>    // io_uring_params, io_uring_sqe
+#include <sys/mman.h>          // mmap
+#include <sys/syscall.h>       // __NR_io_uring_setup
+#include <unistd.h>            // pwrite, syscall
+
+namespace logger {
+/**
+ * @brief io_uringを直接扱う名前空間
+ * @details liburingには依存せず、システムコールと共有リングだけを使う
+ */
+namespace Uring {
+
+/**
+ * @brief 投入・回収を1スレッドから行うio_uring
+ * @details 作った時点では無効（ok()がfalse）。setupで作成に成功した
+ * ときだけ使える
+ */
+class Ring {
+   private:
+    int ring_fd = -1;
+    void* sq_ptr = nullptr;
+    void* cq_ptr = nullptr;
+    size_t sq_size = 0;
+    size_t cq_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned pending = 0;  // 未投入のSQE数
+
+    template <typename T>
+    static T* at(void* base, unsigned offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+
+    void release() {
+        if (sqes != nullptr) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != nullptr && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != nullptr) {
+            munmap(sq_ptr, sq_size);
+        }
+        if (ring_fd >= 0) {
+            ::close(ring_fd);
+        }
+        ring_fd = -1;
+        sq_ptr = cq_ptr = nullptr;
+        sqes = nullptr;
+    }
+
+    /**
+     * @brief io_uring_enterを呼ぶ（EINTRなら呼び直す）
+     * @return 成功したらtrue
+     */
+    bool enter(unsigned wait_for) {
+        for (;;) {
+            unsigned flags = wait_for != 0 ? IORING_ENTER_GETEVENTS : 0;
+            long done = syscall(__NR_io_uring_enter, ring_fd, pending,
+                                wait_for, flags, nullptr, 0);
+            if (done >= 0) {
+                pending -= static_cast<unsigned>(done);
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+   public:
+    Ring() = default;
+
+    /**
+     * @brief リングを作成
+     * @param entries SQEの数（同時に投入できる書き込み数）
+     * @return 作成できたらtrue（未対応のカーネルやseccompで禁止されて
+     * いればfalseで、無効のまま）
+     */
+    bool setup(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd = static_cast<int>(
+            syscall(__NR_io_uring_setup, entries, &params));
+        if (ring_fd < 0) {
+            return false;
+        }
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sq_size = cq_size = sq_size > cq_size ? sq_size : cq_size;
+        }
+        sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            sq_ptr = nullptr;
+            release();
+            return false;
+        }
+        cq_ptr = single ? sq_ptr
+                        : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, ring_fd,
+                               IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqe_ptr = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring_fd,
+                             IORING_OFF_SQES);
+        if (cq_ptr == MAP_FAILED || sqe_ptr == MAP_FAILED) {
+            if (cq_ptr == MAP_FAILED) {
+                cq_ptr = nullptr;
+            }
+            if (sqe_ptr != MAP_FAILED) {
+                sqes = static_cast<io_uring_sqe*>(sqe_ptr);
+            }
+            release();
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqe_ptr);
+
+        sq_head = at<unsigned>(sq_ptr, params.sq_off.head);
+        sq_tail = at<unsigned>(sq_ptr, params.sq_off.tail);
+        sq_mask = at<unsigned>(sq_ptr, params.sq_off.ring_mask);
+        sq_array = at<unsigned>(sq_ptr, params.sq_off.array);
+        cq_head = at<unsigned>(cq_ptr, params.cq_off.head);
+        cq_tail = at<unsigned>(cq_ptr, params.cq_off.tail);
+        cq_mask = at<unsigned>(cq_ptr, params.cq_off.ring_mask);
+        cqes = at<io_uring_cqe>(cq_ptr, params.cq_off.cqes);
+        return true;
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    ~Ring() { release(); }
+
+    /**
+     * @brief リングを使えるか
+     */
+    bool ok() const { return ring_fd >= 0; }
+
+    /**
+     * @brief リングを閉じる（以降ok()はfalse）
+     */
+    void close() { release(); }
+
+    /**
+     * @brief 書き込みを1つ積む（submitで投入）
+     * @param fd 書き込み先
+     * @param data 先頭
+     * @param len バイト数
+     * @param offset ファイル内の位置
+     * @param user_data 完了時に返る値
+     */
+    void prep_write(int fd, const char* data, unsigned len, uint64_t offset,
+                    uint64_t user_data) {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = len;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        pending++;
+    }
+
+    /**
+     * @brief 積んだ書き込みを投入し、必要なら完了を待つ
+     * @param wait_for 待つ完了の数（0なら待たない）
+     * @return 成功したらtrue（失敗時、カーネルは積んだ分を受け取っていない）
+     */
+    bool submit(unsigned wait_for) { return enter(wait_for); }
+
+    /**
+     * @brief 投入していない書き込みを取り消す
+     * @details SQEを投入するのはsubmitだけなので、カーネルがまだ読んで
+     * いない分は末尾を戻せば消える
+     * @return 取り消した数（積んだ順の末尾から）
+     */
+    unsigned drop_pending() {
+        const unsigned dropped = pending;
+        __atomic_store_n(sq_tail, *sq_tail - dropped, __ATOMIC_RELEASE);
+        pending = 0;
+        return dropped;
+    }
+
+    /**
+     * @brief 完了したCQEを取り出す
+     * @param fn 完了毎に呼ばれる(uint64_t user_data, int res)
+     * @return 取り出した数
+     */
+    template <typename F>
+    unsigned reap(F&& fn) {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        unsigned reaped = 0;
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes[head & *cq_mask];
+            fn(cqe.user_data, cqe.res);
+            head++;
+            reaped++;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return reaped;
+    }
+};
+
+}  // namespace Uring
+
+namespace Writers {
+
+/**
+ * @brief io_uringによる非同期ファイル出力クラス
+ * @details LOG_URING_BUFFER_SIZEのブロックをLOG_URING_BLOCKS個持つ。
+ * 埋まったブロックは位置を指定した書き込みとして投入するだけで戻り、
+ * カーネルが書き終えたブロックから（書き込まれた順に）再利用する。
+ * 全ブロックが書き込み中の時だけ完了を待つ。
+ * io_uringを使えない場合はpwriteで同期的に書く
+ */
+class UringWriter : public BaseBufferedWriter {
+   private:
+    /**
+     * @brief 投入中の書き込み
+     */
+    struct Inflight {
+        const char* data;
+        size_t len;
+        uint64_t offset;
+        bool done;
+    };
+
+    int fd;
+    Uring::Ring ring;
+    uint64_t file_offset = 0;   // 次に書く位置
+    uint64_t submitted = 0;     // 投入した書き込みの数
+    uint64_t released_seq = 0;  // 返したブロックの数
+    Inflight inflight[MAX_BLOCKS];
+
+    /**
+     * @brief 全領域をpwriteで書き切る
+     */
+    void pwrite_all(const char* data, size_t len, uint64_t offset) {
+        while (len > 0) {
+            ssize_t done = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+            if (done < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;  // 書けない（ディスクフルなど）: このブロックは捨てる
+            }
+            data += done;
+            len -= static_cast<size_t>(done);
+            offset += static_cast<uint64_t>(done);
+        }
+    }
+
+    /**
+     * @brief 完了したCQEを取り出して記録
+     * @return 取り出した数
+     */
+    unsigned reap() {
+        return ring.reap([this](uint64_t seq, int res) { complete(seq, res); });
+    }
+
+    /**
+     * @brief io_uringをやめて以降はpwriteで書く
+     * @details カーネルが受け取った書き込みは、ブロックを再利用する前に
+     * 完了を待つ（待てなければ諦める）。受け取っていない分は取り消して
+     * pwriteで書く
+     */
+    void fall_back() {
+        const uint64_t accepted = submitted - ring.drop_pending();
+        for (;;) {
+            reap();
+            uint64_t seq = released_seq;
+            while (seq != accepted && inflight[seq % MAX_BLOCKS].done) {
+                seq++;
+            }
+            if (seq == accepted || !ring.submit(1)) {
+                break;
+            }
+        }
+        ring.close();
+        for (uint64_t seq = released_seq; seq != submitted; seq++) {
+            if (!inflight[seq % MAX_BLOCKS].done) {
+                complete(seq, 0);
+            }
+        }
+    }
+
+    /**
+     * @brief 完了を記録し、先頭から連続して完了したブロックを返す
+     */
+    void complete(uint64_t seq, int res) {
+        Inflight& io = inflight[seq % MAX_BLOCKS];
+        size_t written = res > 0 ? static_cast<size_t>(res) : 0;
+        if (written < io.len) {
+            // 失敗・部分書き込み: 残りは同期的に書く
+            pwrite_all(io.data + written, io.len - written,
+                       io.offset + written);
+        }
+        io.done = true;
+        size_t n = 0;
+        while (released_seq != submitted &&
+               inflight[released_seq % MAX_BLOCKS].done) {
+            released_seq++;
+            n++;
+        }
+        if (n != 0) {
+            release_blocks(n);
+        }
+    }
+
+   protected:
+    /**
+     * @brief ブロックを書き込みとして投入（完了は待たない）
+     */
+    void output(const Chunk* chunks, int n) override {
+        for (int i = 0; i < n; i++) {
+            Inflight& io = inflight[submitted % MAX_BLOCKS];
+            io = {chunks[i].data, chunks[i].len, file_offset, false};
+            file_offset += chunks[i].len;
+            if (fd >= 0 && ring.ok()) {
+                ring.prep_write(fd, io.data, static_cast<unsigned>(io.len),
+                                io.offset, submitted);
+            } else if (fd >= 0) {
+                pwrite_all(io.data, io.len, io.offset);
+            }
+            submitted++;
+            if (fd < 0 || !ring.ok()) {
+                complete(submitted - 1, static_cast<int>(io.len));
+            }
+        }
+        if (fd >= 0 && ring.ok() && !ring.submit(0)) {
+            fall_back();  // 投入できない: 以降は同期書き込みにする
+        }
+    }
+
+    /**
+     * @brief 完了した書き込みを回収
+     */
+    void reclaim(bool wait) override {
+        if (!ring.ok()) {
+            return;
+        }
+        if (reap() == 0 && wait && released_seq != submitted) {
+            if (!ring.submit(1)) {
+                // 来ない完了を待ち続けないよう、同期書き込みに切り替える
+                fall_back();
+                return;
+            }
+            reap();
+        }
+    }
+
+   public:
+    /**
+     * @brief コンストラクタ
+     * @param path 出力先（無ければ作成、あれば末尾に追記）
+     * @param use_uring falseならio_uringを使わずpwriteで書く（比較用）
+     */
+    explicit UringWriter(const char* path, bool use_uring = true)
+        : BaseBufferedWriter(LOG_URING_BUFFER_SIZE, LOG_URING_BLOCKS, true),
+          fd(::open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644)) {
+        if (fd < 0) {
+            printf("[ERROR_] ログファイルを開けません: %s\r\n", path);
+            return;
+        }
+        if (use_uring) {
+            ring.setup(static_cast<unsigned>(MAX_BLOCKS));
+        }
+        // 位置を指定して書くため、O_APPENDの代わりに末尾から始める
+        off_t end = lseek(fd, 0, SEEK_END);
+        file_offset = end > 0 ? static_cast<uint64_t>(end) : 0;
+    }
+
+    /**
+     * @brief io_uringで書いているか（falseならpwrite）
+     */
+    bool uses_uring() const { return ring.ok(); }
+
+    /**
+     * @brief デストラクタ - 全ての書き込みの完了を待って閉じる
+     */
+    ~UringWriter() override {
+        flush();
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+}  // namespace Writers
+}  // namespace logger
+
+#endif  // LOG_URING_HPP
@@ -1,12 +1,210 @@
 #ifndef LOG_UTILS_HPP
 #define LOG_UTILS_HPP
 
+// LOG_NO_SIMDを定義するとタグ走査をスカラー実装に固定する
+// ブロック読み込みは文字列の前後も読むので、AddressSanitizerでも固定する
+#if !defined(LOG_NO_SIMD) && defined(__SANITIZE_ADDRESS__)
+#define LOG_NO_SIMD
+#elif !defined(LOG_NO_SIMD) && defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define LOG_NO_SIMD
+#endif
+#endif
+
+#if !defined(LOG_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>  // AVX2
+#elif !defined(LOG_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>  // SSE2
+#endif
+
 namespace logger {
 /**
  * @brief ユーティリティ機能を提供する名前空間
  */
 namespace Utils {
 
+/**
+ * @brief 色タグ走査クラス
+ * @details 検証・ANSI変換・タグ除去を1パスで行う共通処理。
+ * '|'と終端'\0'の位置をSIMD（AVX2/SSE2、無ければスカラー）でまとめて探し、
+ * その間の通常文字はmemcpyで一括コピーする。strlenは使わない
+ */
+class TagScanner {
+   public:
+    /**
+     * @brief 走査モード
+     */
+    enum Mode {
+        VALIDATE,  ///< 検証のみ（出力しない）
+        ANSI,      ///< 色タグをANSIコードに変換
+        STRIP,     ///< 色タグを除去
+    };
+
+    /**
+     * @brief 次の'|'または'\0'を探す
+     * @details SIMD版はアラインされたブロック単位で読むため、
+     * 終端を越えて読んでもページ境界は跨がない
+     * @param p 探索開始位置
+     * @return 見つかった位置
+     */
+    static const char* next_special(const char* p) {
+#if !defined(LOG_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+        // タグが密な文字列では近くにあることが多いので先に数バイト見る
+        for (int i = 0; i < 4; i++, p++) {
+            if (*p == '|' || *p == '\0') {
+                return p;
+            }
+        }
+#endif
+#if !defined(LOG_NO_SIMD) && defined(__AVX2__)
+        const __m256i pipe = _mm256_set1_epi8('|');
+        const __m256i zero = _mm256_setzero_si256();
+        uintptr_t offset = reinterpret_cast<uintptr_t>(p) & 31;
+        const char* block = p - offset;
+        for (;;) {
+            __m256i v =
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, pipe),
+                                _mm256_cmpeq_epi8(v, zero))));
+            mask = (mask >> offset) << offset;  // 開始位置より前を除外
+            if (mask != 0) {
+                return block + __builtin_ctz(mask);
+            }
+            block += 32;
+            offset = 0;
+        }
+#elif !defined(LOG_NO_SIMD) && defined(__SSE2__)
+        const __m128i pipe = _mm_set1_epi8('|');
+        const __m128i zero = _mm_setzero_si128();
+        uintptr_t offset = reinterpret_cast<uintptr_t>(p) & 15;
+        const char* block = p - offset;
+        for (;;) {
+            __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(v, pipe), _mm_cmpeq_epi8(v, zero))));
+            mask = (mask >> offset) << offset;  // 開始位置より前を除外
+            if (mask != 0) {
+                return block + __builtin_ctz(mask);
+            }
+            block += 16;
+            offset = 0;
+        }
+#else
+        while (*p != '|' && *p != '\0') {
+            p++;
+        }
+        return p;
+#endif
+    }
+
+    /**
+     * @brief 色タグを検証しつつ変換・除去（1パス）
+     * @details 不正なタグがあっても出力は従来通り寛容に続ける
+     * （未定義の色タグ文字はそのまま残す）
+     * @param input 入力メッセージ
+     * @param output 出力バッファ（VALIDATEではnullptr可）
+     * @param max_len 出力バッファの最大長
+     * @param mode 走査モード
+     * @param out_len 出力文字数の格納先（'\0'を除く、不要ならnullptr）
+     * @return タグが妥当ならtrue
+     */
+    static bool scan(const char* input, char* output, int max_len, Mode mode,
+                     size_t* out_len = nullptr) {
+        const bool emit = (mode != VALIDATE);
+        const size_t cap = emit ? static_cast<size_t>(max_len) - 1 : 0;
+        bool valid = (input[0] != '|');  // 先頭が|は不正
+        bool pipe_odd = false;           // falseなら偶数、開始タグ
+        size_t out_pos = 0;
+        const char* p = input;
+
+        for (;;) {
+            const char* q = next_special(p);
+            if (emit) {
+                append(output, out_pos, cap, p, q - p);
+            }
+            if (*q == '\0') {
+                break;
+            }
+
+            //  | があった:
+            if (!pipe_odd) {  // 偶数、開始タグ
+                // |連続はエスケープされたリテラル|として処理
+                if (q[1] == '|') {
+                    if (emit) {
+                        append(output, out_pos, cap, q, 1);
+                    }
+                    p = q + 2;
+                    continue;
+                }
+                char tag = (q > input) ? q[-1] : '\0';
+                const char* code = ColorMap::ansi_code(tag);
+                if (code == nullptr) {
+                    valid = false;
+                    if (!emit) {
+                        return false;
+                    }
+                }
+                if (mode == STRIP || (mode == ANSI && code != nullptr)) {
+                    if (out_pos > 0) {
+                        out_pos--;  // 色タグの文字を上書き
+                    }
+                }
+                if (mode == ANSI && code != nullptr) {
+                    append_whole(output, out_pos, cap, code,
+                                 ColorMap::ansi_length(tag));
+                }
+                pipe_odd = true;
+            } else {  // 奇数、終了タグ
+                if (mode == ANSI) {
+                    append_whole(output, out_pos, cap, ColorMap::RESET,
+                                 ColorMap::RESET_LEN);
+                }
+                pipe_odd = false;
+            }
+            p = q + 1;
+        }
+
+        if (emit) {
+            output[out_pos] = '\0';
+        }
+        if (out_len != nullptr) {
+            *out_len = out_pos;
+        }
+        return valid && !pipe_odd;  // 偶数ならtrue
+    }
+
+   private:
+    /**
+     * @brief 入る分だけ追加
+     */
+    static void append(char* output, size_t& out_pos, size_t cap,
+                       const char* src, size_t len) {
+        if (out_pos + len > cap) {
+            len = cap - out_pos;
+        }
+        if (len <= 4) {  // タグ間の短い区間はmemcpy呼び出しを避ける
+            for (size_t i = 0; i < len; i++) {
+                output[out_pos + i] = src[i];
+            }
+        } else {
+            memcpy(output + out_pos, src, len);
+        }
+        out_pos += len;
+    }
+
+    /**
+     * @brief 全体が入る場合のみ追加（エスケープシーケンスを途中で切らない）
+     */
+    static void append_whole(char* output, size_t& out_pos, size_t cap,
+                             const char* src, size_t len) {
+        if (out_pos + len <= cap) {
+            memcpy(output + out_pos, src, len);
+            out_pos += len;
+        }
+    }
+};
+
 /**
  * @brief カラー処理統合クラス
  * @details カラータグの解析、ANSIコード変換などを一元管理
@@ -22,8 +220,7 @@ class ColorHelper {
     static const char* get_level_color(LogLevel level, bool color_enabled) {
         if (!color_enabled) return "";
 
-        auto it = ColorMap::LEVEL_COLORS.find(level);
-        return (it != ColorMap::LEVEL_COLORS.end()) ? it->second : "";
+        return ColorMap::level_code(level);
     }
 
     /**
@@ -40,89 +237,215 @@ class ColorHelper {
      * @param input 入力メッセージ
      * @param output 出力バッファ
      * @param max_len 最大長
-     * @param color_enabled カラー出力が有効か
+     * @return タグが妥当ならtrue
      */
-    static void parse_color_tags(const char* input, char* output, int max_len) {
-        bool pipe_odd = false;  // falseなら偶数、開始タグ
-        int out_pos = 0;
-        int input_len = strlen(input);
+    static bool parse_color_tags(const char* input, char* output, int max_len) {
+        return TagScanner::scan(input, output, max_len, TagScanner::ANSI);
+    }
 
-        for (int i = 0; i < input_len && out_pos < max_len - 1; i++) {
+    /**
+     * @brief メッセージからカラータグを除去
+     * @param input 入力メッセージ
+     * @param output 出力バッファ
+     * @param max_len 最大長
+     * @return タグが妥当ならtrue
+     */
+    static bool strip_color_tags(const char* input, char* output, int max_len) {
+        return TagScanner::scan(input, output, max_len, TagScanner::STRIP);
+    }
+};
+
+/**
+ * @brief コンパイル時に変換した文字列の格納先
+ * @tparam N 終端'\0'を含むバイト数
+ */
+template <size_t N>
+struct CtString {
+    char data[N];
+};
+
+/**
+ * @brief 色タグのコンパイル時変換クラス
+ * @details フォーマット文字列リテラルの色タグを、ANSIコード埋め込み版と
+ * タグ除去版に変換する。%sなどの変換指定の直後のタグ（"%s|%.2f|"）は
+ * 引数で色が決まるため変換せずに残す。
+ * 実行時解析が必要な文字列では"||"もエスケープのまま残す
+ */
+class ColorTranslator {
+   public:
+    /**
+     * @brief printf変換文字か
+     */
+    static constexpr bool is_conversion(char c) {
+        return c == 'd' || c == 'i' || c == 'u' || c == 'o' || c == 'x' ||
+               c == 'X' || c == 'e' || c == 'E' || c == 'f' || c == 'F' ||
+               c == 'g' || c == 'G' || c == 'a' || c == 'A' || c == 'c' ||
+               c == 's' || c == 'p' || c == 'n';
+    }
+
+    /**
+     * @brief 変換指定をスキップ
+     * @param input フォーマット文字列
+     * @param i '%'の位置
+     * @return 変換文字の位置（見つからなければ終端の位置）
+     */
+    static constexpr int skip_conversion(const char* input, int i) {
+        i++;
+        while (input[i] != '\0' && !is_conversion(input[i])) {
+            i++;
+        }
+        return i;
+    }
+
+   private:
+    /**
+     * @brief 1文字出力（outがnullptrなら数えるだけ）
+     */
+    static constexpr void put(char* out, size_t& pos, char c) {
+        if (out != nullptr) {
+            out[pos] = c;
+        }
+        pos++;
+    }
+
+    /**
+     * @brief 文字列出力（outがnullptrなら数えるだけ）
+     */
+    static constexpr void put(char* out, size_t& pos, const char* str) {
+        for (int i = 0; str[i] != '\0'; i++) {
+            put(out, pos, str[i]);
+        }
+    }
+
+    /**
+     * @brief 変換本体
+     * @param input フォーマット文字列
+     * @param ansi true: ANSIコード埋め込み, false: タグ除去
+     * @param out 出力先（nullptrなら長さ計算のみ）
+     * @return 出力文字数（'\0'を除く）
+     */
+    static constexpr size_t run(const char* input, bool ansi, char* out) {
+        const bool keep_escape = runtime_tags(input);
+        bool pipe_odd = false;     // falseなら偶数、開始タグ
+        bool dynamic_tag = false;  // 開いているタグが引数で決まる
+        int conv_pos = -1;         // 直前の変換文字の位置
+        size_t pos = 0;
+
+        for (int i = 0; input[i] != '\0'; i++) {
+            if (input[i] == '%') {
+                if (input[i + 1] == '%') {
+                    put(out, pos, '%');
+                    put(out, pos, '%');
+                    i++;
+                    continue;
+                }
+                int end = skip_conversion(input, i);
+                for (; i < end && input[i] != '\0'; i++) {
+                    put(out, pos, input[i]);
+                }
+                if (input[i] == '\0') {
+                    break;
+                }
+                put(out, pos, input[i]);
+                conv_pos = i;
+                continue;
+            }
             if (input[i] != '|') {
-                // 通常文字
-                output[out_pos++] = input[i];
+                put(out, pos, input[i]);
                 continue;
             }
 
             //  | があった:
             if (!pipe_odd) {  // 偶数、開始タグ
-                // |連続はエスケープされたリテラル|として処理
-                if (i + 1 < input_len && input[i + 1] == '|') {
-                    output[out_pos++] = '|';  // リテラル|を出力
-                    i++;                      // 次の|もスキップ
+                // |連続はエスケープされたリテラル|
+                if (input[i + 1] == '|') {
+                    put(out, pos, '|');
+                    if (keep_escape) {
+                        put(out, pos, '|');
+                    }
+                    i++;
                     continue;
                 }
-                // カラータグ開始処理 (x|形式)
-                auto it = ColorMap::ANSI_COLORS.find(input[i - 1]);
-                if (it != ColorMap::ANSI_COLORS.end()) {
-                    out_pos--;  // 色タグの文字を上書き
-                    const char* color_code = it->second;
-                    int code_len = strlen(color_code);
-                    if (out_pos + code_len < max_len - 1) {
-                        strcpy(output + out_pos, color_code);
-                        out_pos += code_len;
+                dynamic_tag = (i > 0 && conv_pos == i - 1);
+                if (dynamic_tag) {
+                    put(out, pos, '|');  // 実行時に解析
+                } else if (i > 0) {
+                    pos--;  // 色タグの文字を上書き
+                    const char* code = ColorMap::ansi_code(input[i - 1]);
+                    if (ansi && code != nullptr) {
+                        put(out, pos, code);
                     }
                 }
                 pipe_odd = true;
-                continue;
             } else {  // 奇数、終了タグ
-                      // カラー終了タグ (単独の|)
-                int reset_len = strlen(ColorMap::RESET);
-                if (out_pos + reset_len < max_len - 1) {
-                    strcpy(output + out_pos, ColorMap::RESET);
-                    out_pos += reset_len;
+                if (dynamic_tag) {
+                    put(out, pos, '|');
+                } else if (ansi) {
+                    put(out, pos, ColorMap::RESET);
                 }
+                dynamic_tag = false;
                 pipe_odd = false;
             }
         }
-        output[out_pos] = '\0';
+        if (out != nullptr) {
+            out[pos] = '\0';
+        }
+        return pos;
     }
 
+   public:
     /**
-     * @brief メッセージからカラータグを除去
-     * @param input 入力メッセージ
-     * @param output 出力バッファ
-     * @param max_len 最大長
+     * @brief 実行時の色タグ解析が必要か
+     * @details %s引数や変換指定直後のタグは実行時まで内容が分からない
+     * @param input フォーマット文字列
+     * @return 必要ならtrue
      */
-    static void strip_color_tags(const char* input, char* output, int max_len) {
-        bool pipe_odd = false;  // falseなら偶数、開始タグ
-        int out_pos = 0;
-        int input_len = strlen(input);
-
-        for (int i = 0; i < input_len && out_pos < max_len - 1; i++) {
-            if (input[i] != '|') {
-                // 通常文字
-                output[out_pos++] = input[i];
+    static constexpr bool runtime_tags(const char* input) {
+        for (int i = 0; input[i] != '\0'; i++) {
+            if (input[i] != '%') {
                 continue;
             }
-
-            //  | があった:
-            if (!pipe_odd) {  // 偶数、開始タグ
-                // |連続はエスケープされたリテラル|として処理
-                if (i + 1 < input_len && input[i + 1] == '|') {
-                    output[out_pos++] = '|';  // リテラル|を出力
-                    i++;                      // 次の|もスキップ
-                    continue;
-                }
-                // カラータグ開始処理 (x|形式) - スキップ
-                pipe_odd = true;
+            if (input[i + 1] == '%') {
+                i++;
                 continue;
-            } else {  // 奇数、終了タグ
-                // カラー終了タグ (単独の|) - スキップ
-                pipe_odd = false;
+            }
+            i = skip_conversion(input, i);
+            if (input[i] == '\0') {
+                break;
+            }
+            if (input[i] == 's' || input[i + 1] == '|') {
+                return true;
             }
         }
-        output[out_pos] = '\0';
+        return false;
+    }
+
+    /**
+     * @brief ANSIコードに変換されるタグを含むか
+     * @details 含まなければANSI版とタグ除去版は同じ文字列になる
+     */
+    static constexpr bool has_static_tags(const char* input) {
+        return run(input, true, nullptr) != run(input, false, nullptr);
+    }
+
+    /**
+     * @brief 変換後のバイト数（'\0'を含む）
+     */
+    static constexpr size_t translated_size(const char* input, bool ansi) {
+        return run(input, ansi, nullptr) + 1;
+    }
+
+    /**
+     * @brief 色タグを変換した文字列を生成
+     * @tparam N translated_size()で求めたバイト数
+     * @param input フォーマット文字列
+     * @param ansi true: ANSIコード埋め込み, false: タグ除去
+     */
+    template <size_t N>
+    static constexpr CtString<N> translate(const char* input, bool ansi) {
+        CtString<N> result{};
+        run(input, ansi, result.data);
+        return result;
     }
 };
 
@@ -138,11 +461,13 @@ class ValidationUtils {
      * @return true: 妥当, false: 不正
      * @details
      * - | が先頭でない
-     * - 色タグが a-z の範囲内か（簡易チェック）
+     * - 色タグがColorMapに定義されているか
+     *   （"%s|"のように変換指定の直後なら引数で決まるため許可）
      * - | が偶数か
      */
     static constexpr bool check_colors_ct(const char* input) {
         bool pipe_odd = false;  // falseなら偶数、開始タグ
+        int conv_pos = -1;      // 直前の変換文字の位置
         int input_len = 0;
 
         // 文字列長を計算
@@ -156,6 +481,15 @@ class ValidationUtils {
         }
 
         for (int i = 0; i < input_len; i++) {
+            if (input[i] == '%') {
+                if (input[i + 1] == '%') {
+                    i++;
+                } else {
+                    i = ColorTranslator::skip_conversion(input, i);
+                    conv_pos = i;
+                }
+                continue;
+            }
             if (input[i] != '|') {
                 continue;
             }
@@ -167,8 +501,9 @@ class ValidationUtils {
                     i++;
                     continue;
                 }
-                // 開始タグの前の色タグが正しいか（a-z の簡易チェック）
-                if (input[i - 1] < 'a' || input[i - 1] > 'z') {
+                // 開始タグの前の色タグが正しいか
+                if (conv_pos != i - 1 &&
+                    ColorMap::ansi_code(input[i - 1]) == nullptr) {
                     return false;
                 }
                 pipe_odd = true;
@@ -185,50 +520,13 @@ class ValidationUtils {
      * @brief カラータグの妥当性をチェック（実行時）
      * @details チェック事項
      * - | が先頭でない
-     * - 色タグがColorMap::ANSI_COLORSに含まれるか
+     * - 色タグがColorMapに定義されているか
      * - | が偶数か
      * @param input チェック対象の文字列
      * @return true: 妥当, false: 不正
      */
     static bool validate_color_tags_runtime(const char* input) {
-        bool pipe_odd = false;  // falseなら偶数、開始タグ
-        int input_len = strlen(input);
-
-        // 先頭が|でないかチェック
-        if (input_len > 0 && input[0] == '|') {
-            return false;
-        }
-
-        for (int i = 0; i < input_len; i++) {
-            if (input[i] != '|') {
-                continue;
-            }
-
-            //  | があった:
-            if (!pipe_odd) {  // 偶数、開始タグ
-                // |連続はスキップ
-                if (i + 1 < input_len && input[i + 1] == '|') {
-                    i++;
-                    continue;
-                }
-                // 開始タグの前の色タグが正しいか
-                if (ColorMap::ANSI_COLORS.count(input[i - 1]) == 0) {
-                    return false;
-                }
-                pipe_odd = true;
-                continue;
-            } else {  // 奇数、終了タグ
-                pipe_odd = false;
-            }
-        }
-
-        if (!pipe_odd) {
-            // 偶数ok
-            return true;
-        } else {
-            // 奇数no
-            return false;
-        }
+        return TagScanner::scan(input, nullptr, 0, TagScanner::VALIDATE);
     }
 };
 
@@ -256,7 +554,7 @@ class StringUtils {
      * @param level ログレベル
      * @return レベル文字列
      */
-    static const char* get_level_string(LogLevel level) {
+    static constexpr const char* get_level_string(LogLevel level) {
         switch (level) {
             case LogLevel::DEBUG_:
                 return "DEBUG";
@@ -272,61 +570,239 @@ class StringUtils {
     }
 
     /**
-     * @brief LogEntry専用snprintfラッパー
-     * @details LogEntryのformatedMsgバッファに直接フォーマット出力
-     * @param entry 出力先のLogEntry
-     * @param format フォーマット文字列
-     * @param ... 可変長引数
-     * @return フォーマット済み文字数（バッファサイズ制限内）
+     * @brief 安全な文字列コピー
+     * @param dest 宛先バッファ
+     * @param src ソース文字列
+     * @param max_len 最大長
      */
-    static int log_sprintf(const LogEntry& entry, const char* format, ...) {
-        va_list args;
-        va_start(args, format);
-        int result = vsnprintf(entry.formatedMsg, LOG_FMT_SIZE, format, args);
-        va_end(args);
-        return result;
+    static void safe_strcpy(char* dest, const char* src, int max_len) {
+        strncpy(dest, src, max_len - 1);
+        dest[max_len - 1] = '\0';
     }
+};
 
+/**
+ * @brief 出力先バッファへ1行を組み立てるクラス
+ * @details printf系を使わずに文字列・数値・パディングを直接書き込む。
+ * 容量を超えた分は切り詰め、常に'\0'終端を保つ
+ */
+class LineBuilder {
+   private:
+    char* out;
+    size_t cap;  // '\0'を除いた書き込み可能バイト数
+    size_t pos = 0;
+
+   public:
     /**
-     * @brief 汎用パディング関数
-     * @param text パディング対象文字列
-     * @param target_width 目標幅
-     * @param output 出力バッファ（target_width+1以上）
-     * @param align_left 左揃え
-     * @param pad_char パディング文字
+     * @brief コンストラクタ
+     * @param buffer 出力先
+     * @param size 出力先のサイズ（1以上）
      */
-    static void apply_padding(const char* text, int target_width, char* output,
-                              bool align_left = true, char pad_char = ' ') {
-        int text_len = strlen(text);
-        int padding = target_width - text_len;
-        size_t buffer_size = target_width + 1;
+    LineBuilder(char* buffer, size_t size) : out(buffer), cap(size - 1) {
+        out[0] = '\0';
+    }
 
-        if (padding <= 0) {
-            // パディング不要またはテキストが長すぎる場合
-            snprintf(output, buffer_size, "%s", text);
+    /**
+     * @brief 長さ指定で追加
+     */
+    void append(const char* str, size_t len) {
+        if (len > cap - pos) {
+            len = cap - pos;
+        }
+        memcpy(out + pos, str, len);
+        pos += len;
+        out[pos] = '\0';
+    }
+
+    /**
+     * @brief '\0'終端文字列を追加
+     */
+    void append(const char* str) { append(str, strlen(str)); }
+
+    /**
+     * @brief 1文字追加
+     */
+    void append(char c) { append(&c, 1); }
+
+    /**
+     * @brief 符号なし整数を10進で追加
+     * @return 桁数
+     */
+    size_t append_uint(unsigned value) {
+        char digits[10];
+        size_t n = 0;
+        do {
+            n++;
+            digits[sizeof(digits) - n] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        append(digits + sizeof(digits) - n, n);
+        return n;
+    }
+
+    /**
+     * @brief 同じ文字をcount個追加（0以下なら何もしない）
+     */
+    void fill(char c, int count) {
+        if (count <= 0) {
             return;
         }
+        size_t len = static_cast<size_t>(count);
+        if (len > cap - pos) {
+            len = cap - pos;
+        }
+        memset(out + pos, c, len);
+        pos += len;
+        out[pos] = '\0';
+    }
 
-        if (align_left) {
-            // 左揃え: "text    "
-            snprintf(output, buffer_size, "%s%*s", text, padding, "");
-        } else {
-            // 右揃え: "    text"
-            snprintf(output, buffer_size, "%*s%s", padding, "", text);
+    /**
+     * @brief 現在位置の書き込み先（直接書く場合に使用）
+     */
+    char* cursor() { return out + pos; }
+
+    /**
+     * @brief 残りの容量（'\0'を含む）
+     */
+    size_t remaining() const { return cap - pos + 1; }
+
+    /**
+     * @brief cursor()へ直接書いた分だけ進める
+     */
+    void advance(size_t len) {
+        pos += (len > cap - pos) ? cap - pos : len;
+        out[pos] = '\0';
+    }
+
+    /**
+     * @brief 書き込んだ文字数（'\0'を除く）
+     */
+    size_t size() const { return pos; }
+};
+/**
+ * @brief 呼び出し箇所ヘッダのコンパイル時描画クラス
+ * @details ConsoleFmt/PlainFmtが実行時に組み立てるヘッダと同じ文字列を、
+ * LOG_*マクロの展開時に__FILE__と__LINE__から作る
+ */
+class SiteRenderer {
+   public:
+    /**
+     * @brief ヘッダの形式
+     */
+    enum Style {
+        CONSOLE,  ///< "[LEVEL]  file:line    : "（ConsoleFmt）
+        BRIEF,    ///< "[LEVEL] file:line : "（PlainFmt）
+    };
+
+    /**
+     * @brief パスからファイル名部分を取得（コンパイル時版）
+     */
+    static constexpr const char* basename(const char* path) {
+        const char* name = path;
+        for (const char* p = path; *p != '\0'; p++) {
+            if (*p == '/' || *p == '\\') {
+                name = p + 1;
+            }
         }
+        return name;
     }
 
     /**
-     * @brief 安全な文字列コピー
-     * @param dest 宛先バッファ
-     * @param src ソース文字列
-     * @param max_len 最大長
+     * @brief レベル欄の幅（"[LEVEL]"を8文字にパディング）
      */
-    static void safe_strcpy(char* dest, const char* src, int max_len) {
-        strncpy(dest, src, max_len - 1);
-        dest[max_len - 1] = '\0';
+    static constexpr size_t level_width(LogLevel level) {
+        size_t width = length(StringUtils::get_level_string(level)) + 2;
+        return width < 8 ? 8 : width;
+    }
+
+    /**
+     * @brief 描画後のサイズ
+     * @return 終端'\0'を含むバイト数
+     */
+    static constexpr size_t header_size(const char* path, int line,
+                                        LogLevel level, Style style) {
+        size_t location = length(basename(path)) + digits(line);
+        if (style == BRIEF) {
+            return length(StringUtils::get_level_string(level)) + 2 + 1 +
+                   location + 1 + 3 + 1;
+        }
+        return level_width(level) + 1 + location + 1 + padding(location) + 3 +
+               1;
+    }
+
+    /**
+     * @brief ヘッダを描画
+     * @tparam N header_sizeで求めたサイズ
+     */
+    template <size_t N>
+    static constexpr CtString<N> render(const char* path, int line,
+                                        LogLevel level, Style style) {
+        CtString<N> result{};
+        const char* level_str = StringUtils::get_level_string(level);
+        const char* name = basename(path);
+        size_t pos = 0;
+
+        result.data[pos++] = '[';
+        pos = copy(result.data, pos, level_str);
+        result.data[pos++] = ']';
+        if (style == CONSOLE) {
+            while (pos < level_width(level)) {
+                result.data[pos++] = ' ';
+            }
+        }
+        result.data[pos++] = ' ';
+
+        pos = copy(result.data, pos, name);
+        result.data[pos++] = ':';
+        unsigned value = static_cast<unsigned>(line);
+        size_t width = digits(line);
+        for (size_t i = width; i > 0; i--) {
+            result.data[pos + i - 1] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        pos += width;
+        if (style == CONSOLE) {
+            for (size_t i = padding(length(name) + width); i > 0; i--) {
+                result.data[pos++] = ' ';
+            }
+        }
+        pos = copy(result.data, pos, " : ");
+        result.data[pos] = '\0';
+        return result;
+    }
+
+   private:
+    static constexpr size_t length(const char* str) {
+        size_t n = 0;
+        while (str[n] != '\0') {
+            n++;
+        }
+        return n;
+    }
+
+    static constexpr size_t digits(int line) {
+        unsigned value = static_cast<unsigned>(line);
+        size_t n = 1;
+        while (value >= 10) {
+            value /= 10;
+            n++;
+        }
+        return n;
+    }
+
+    // ファイル名+行番号を13文字に揃えるパディング
+    static constexpr size_t padding(size_t location) {
+        return location < 13 ? 13 - location : 0;
+    }
+
+    static constexpr size_t copy(char* out, size_t pos, const char* str) {
+        while (*str != '\0') {
+            out[pos++] = *str++;
+        }
+        return pos;
     }
 };
+
 }  // namespace Utils
 }  // namespace logger
 
@@ -1,7 +1,22 @@
 #ifndef LOG_WRITERS_HPP
 #define LOG_WRITERS_HPP
 
+#include <atomic>  // 共有バッファの位置確保
+#include <chrono>  // FileWriterの同期間隔
 #include <cstdio>
+#include <thread>  // std::this_thread::yield
+
+#if LOG_FILE
+#include <errno.h>    // EINTR
+#include <fcntl.h>    // open
+#include <sys/uio.h>  // writev
+#include <unistd.h>   // close, fdatasync
+#include <condition_variable>  // ローテーションスレッドの起床
+#include <string>              // ローテーション先のファイル名
+#if LOG_ZLIB
+#include <zlib.h>  // gzopen, gzwrite（-lzが必要）
+#endif
+#endif
 
 namespace logger {
 /**
@@ -19,6 +34,8 @@ class IWriter {
 
     /**
      * @brief メッセージを出力
+     * @details reserveがnullptrを返すwriterに対して、
+     * entry.formatedMsgへフォーマットした後に呼ばれる
      * @param message 出力するメッセージ
      */
     virtual void write(const LogEntry& entry) = 0;
@@ -27,6 +44,28 @@ class IWriter {
      * @brief BaseBufferedWriterの為
      */
     virtual void flush() = 0;
+
+    /**
+     * @brief フォーマッタが直接書き込む領域を予約
+     * @details 領域を返すwriterには、フォーマッタが1行を直接書き込み、
+     * commitで確定する（writeは呼ばれない）
+     * @param size 必要なバイト数（'\0'を含む）
+     * @return 書き込み先、対応しない場合nullptr
+     */
+    virtual char* reserve(size_t size) {
+        (void)size;
+        return nullptr;
+    }
+
+    /**
+     * @brief reserveした領域への書き込みを確定
+     * @param entry 書き込んだレコード（レベルなどの参照用）
+     * @param len 書き込んだ文字数（'\0'を除く）
+     */
+    virtual void commit(const LogEntry& entry, size_t len) {
+        (void)entry;
+        (void)len;
+    }
 };
 
 /**
@@ -42,6 +81,11 @@ class ConsoleWriter : public IWriter {
     void write(const LogEntry& entry) override {
         printf("%s\n", entry.formatedMsg);
     }
+
+    /**
+     * @brief 標準出力をflush
+     */
+    void flush() override { fflush(stdout); }
 };
 
 class DebugWriter : public IWriter {
@@ -72,89 +116,301 @@ class DebugWriter : public IWriter {
         // 改行
         printf("\n\n");
     }
+
+    /**
+     * @brief 標準出力をflush
+     */
+    void flush() override { fflush(stdout); }
 };
 
 /**
  * @brief バッファ付き出力基底クラス
- * @details メッセージをバッファリングして出力する基底クラス
+ * @details メッセージをバッファリングして出力する基底クラス。
+ * 複数スレッドから同時に書き込める。各スレッドは自分専用のバッファで
+ * 1行を組み立て、共有バッファへは位置をfetch_addで確保してコピーする
+ * （ロックなし）。共有バッファは複数のブロックからなる輪で、ブロックが
+ * 埋まったら溢れさせたスレッドが次のブロックへ切り替える。埋まった
+ * ブロックは出力中のスレッドが無ければその場で、あれば出力中のスレッドが
+ * まとめて（溜まった分を1回で）outputへ渡す
  */
 class BaseBufferedWriter : public IWriter {
+   public:
+    static constexpr size_t MAX_BLOCKS = 16;  // ブロック数の上限
+
+    /**
+     * @brief outputへ渡す連続領域
+     */
+    struct Chunk {
+        const char* data;  ///< 改行済みの行の並び
+        size_t len;        ///< バイト数
+    };
+
    private:
-    char buffer[BUFFER_SIZE];
-    int buffer_pos = 0;
+    // ブロックを封印した印（これ以降の確保は必ず容量を超える）
+    static constexpr size_t SEALED = static_cast<size_t>(-1) / 2;
+
+    // 計数が他のブロックの計数と同じキャッシュラインに載らないよう
+    // パディングで離す（alignasはC++14のnewで保証されないため使わない）
+    struct Block {
+        std::atomic<size_t> reserved{SEALED};  // 確保済みバイト数
+        std::atomic<size_t> committed{0};      // 書き込み完了バイト数
+        size_t used = 0;  // 封印時点の確保済みバイト数（封印したスレッドが書く）
+        char pad[64];
+    };
+
+    const size_t capacity;  // 1ブロックのバイト数
+    const size_t count;     // ブロック数
+    std::unique_ptr<Block[]> blocks;
+    char* data;  // count * capacityバイト（ページ境界）
+
+    char pad[64];
+    // 書き込み中のブロックの世代（世代 % countがブロック番号）。
+    // ブロック番号だけで待つと一周する切り替えを見逃すため、世代で待つ
+    std::atomic<size_t> generation{0};
+    std::atomic<size_t> written{0};        // 出力済みの世代数
+    std::atomic<size_t> released{0};       // 再利用できる世代数
+    std::atomic<bool> output_busy{false};  // 出力中（出力は1スレッドずつ）
+    const bool hold_blocks;  // outputから戻った後もブロックを保持する
 
-   public:
     /**
-     * @brief コンストラクタ
+     * @brief 1行を共有バッファへ追加
+     * @param line 行
+     * @param len 行の長さ
+     * @param newline 改行（\r\n）を付けるか
+     */
+    void append(const char* line, size_t len, bool newline = true) {
+        const size_t tail = newline ? 2 : 0;
+        if (len + tail > capacity) {
+            len = capacity - tail;
+        }
+        const size_t total = len + tail;
+        for (;;) {
+            size_t gen = generation.load(std::memory_order_acquire);
+            size_t index = gen % count;
+            Block& block = blocks[index];
+            size_t offset =
+                block.reserved.fetch_add(total, std::memory_order_acq_rel);
+            if (offset + total <= capacity) {
+                char* out = data + index * capacity + offset;
+                memcpy(out, line, len);
+                if (newline) {
+                    out[len] = '\r';
+                    out[len + 1] = '\n';
+                }
+                block.committed.fetch_add(total, std::memory_order_release);
+                return;
+            }
+            if (offset <= capacity) {
+                // 最初に溢れさせたスレッドが切り替えを担当
+                seal(index, offset);
+            } else {
+                while (generation.load(std::memory_order_acquire) == gen) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 封印したブロックから次のブロックへ切り替える
+     * @details 封印したスレッドは世代毎に1つだけなので、世代の更新は
+     * 競合しない。次のブロックが出力待ちなら出力を手伝いながら待つ
+     * @param index 封印したブロック
+     * @param used 封印時点の確保済みバイト数
+     */
+    void seal(size_t index, size_t used) {
+        // 古い世代を読んだスレッドが封印した場合は、そのブロックが
+        // 書き込み先になるまで待つ（直前の切り替えの途中）
+        size_t gen = generation.load(std::memory_order_acquire);
+        while (gen % count != index) {
+            std::this_thread::yield();
+            gen = generation.load(std::memory_order_acquire);
+        }
+        blocks[index].used = used;
+
+        const size_t next = gen + 1;
+        while (next >= released.load(std::memory_order_acquire) + count) {
+            drain(true);
+            std::this_thread::yield();
+        }
+        Block& block = blocks[next % count];
+        block.committed.store(0, std::memory_order_relaxed);
+        block.reserved.store(0, std::memory_order_release);
+        generation.store(next);
+        drain();
+    }
+
+    /**
+     * @brief 封印済みで未出力のブロックをまとめて出力
+     * @details 他のスレッドが出力中なら何もしない（そのスレッドが
+     * 出力後に再確認して拾う）。ブロックを保持するwriterでは、
+     * 続けてreclaimで完了した出力を回収する
+     * @param waiting 空きブロックを待っている（reclaimで完了を待ってよい）
+     */
+    void drain(bool waiting = false) {
+        do {
+            if (output_busy.exchange(true)) {
+                return;
+            }
+            size_t from = written.load(std::memory_order_relaxed);
+            size_t to = generation.load();  // 未出力はcount個以下
+            if (from != to) {
+                Chunk chunks[MAX_BLOCKS];
+                int n = 0;
+                for (size_t gen = from; gen != to; gen++) {
+                    size_t index = gen % count;
+                    Block& block = blocks[index];
+                    // 確保済みの行の書き込み完了を待つ
+                    while (block.committed.load(std::memory_order_acquire) !=
+                           block.used) {
+                        std::this_thread::yield();
+                    }
+                    chunks[n++] = {data + index * capacity, block.used};
+                }
+                output(chunks, n);
+                written.store(to, std::memory_order_release);
+                if (!hold_blocks) {
+                    released.store(to, std::memory_order_release);
+                }
+            }
+            if (hold_blocks && released.load(std::memory_order_relaxed) !=
+                                   written.load(std::memory_order_relaxed)) {
+                reclaim(waiting);
+            }
+            output_busy.store(false);
+        } while (written.load() != generation.load());
+    }
+
+   protected:
+    /**
+     * @brief バッファの内容を出力（継承先で実装）
+     * @details 出力は常に1スレッドずつ、書き込まれた順に呼ばれる
+     * @param chunks 出力する領域の並び（書き込まれた順）
+     * @param n 領域の数（1〜ブロック数）
+     */
+    virtual void output(const Chunk* chunks, int n) {
+        // 基底クラスでは捨てるのみ
+        (void)chunks;
+        (void)n;
+    }
+
+    /**
+     * @brief 保持しているブロックの出力完了を回収（継承先で実装）
+     * @details hold_blocksのwriterでのみ、outputと同じく1スレッドずつ
+     * 呼ばれる。完了したブロックはrelease_blocksで返す
+     * @param wait 1つも完了していなければ完了を待ってよい
      */
-    BaseBufferedWriter() { buffer[0] = '\0'; }
+    virtual void reclaim(bool wait) { (void)wait; }
+
     /**
-     * @brief バッファの内容を取得
-     * @return バッファの内容
+     * @brief 出力が完了したブロックを再利用可能にする
+     * @details output/reclaimの中から、outputへ渡した順に呼ぶ
+     * @param n ブロック数
      */
-    const char* get_buffer() const { return buffer; }
+    void release_blocks(size_t n) {
+        released.store(released.load(std::memory_order_relaxed) + n,
+                       std::memory_order_release);
+    }
 
     /**
-     * @brief バッファをクリア
+     * @brief 改行を付けずに共有バッファへ追加（バイナリレコード用）
      */
-    void clear_buffer() {
-        buffer_pos = 0;
-        buffer[0] = '\0';
+    void append_raw(const char* data, size_t len) { append(data, len, false); }
+
+   public:
+    /**
+     * @brief コンストラクタ
+     * @param block_size 1ブロックのバイト数（LOG_FMT_SIZE以上）
+     * @param block_count ブロック数（2〜MAX_BLOCKS）
+     * @param hold trueならoutputから戻った後もブロックを保持し、
+     * release_blocksで返すまで再利用しない（非同期出力用）
+     */
+    explicit BaseBufferedWriter(size_t block_size = BUFFER_SIZE,
+                                size_t block_count = 2, bool hold = false)
+        : capacity(block_size < LOG_FMT_SIZE ? LOG_FMT_SIZE : block_size),
+          count(block_count < 2            ? 2
+                : block_count > MAX_BLOCKS ? MAX_BLOCKS
+                                           : block_count),
+          blocks(new Block[count]),
+          data(Memory::aligned_bytes(capacity * count, 4096)),
+          hold_blocks(hold) {
+        blocks[0].reserved.store(0, std::memory_order_relaxed);
     }
 
+    BaseBufferedWriter(const BaseBufferedWriter&) = delete;
+    BaseBufferedWriter& operator=(const BaseBufferedWriter&) = delete;
+
     /**
      * @brief バッファが空かどうかを確認
      * @return 空の場合true
      */
-    bool is_empty() const { return buffer_pos == 0; }
+    bool is_empty() const {
+        size_t gen = generation.load(std::memory_order_acquire);
+        return written.load(std::memory_order_acquire) == gen &&
+               blocks[gen % count].reserved.load(std::memory_order_relaxed) ==
+                   0;
+    }
 
     /**
      * @brief バッファにメッセージを保存
      * @param message 保存するメッセージ
      */
     void write(const LogEntry& entry) override {
-        int msg_len = strlen(entry.formatedMsg);
-
-        // バッファに余裕がない場合はフラッシュ
-        if (buffer_pos + msg_len + 1 >= BUFFER_SIZE) {
-            flush();
-        }
-
-        // バッファに追加
-        strncpy(buffer + buffer_pos, entry.formatedMsg,
-                BUFFER_SIZE - buffer_pos - 1);
-        buffer_pos += msg_len;
-
-        // バッファに改行を追加
-        if (buffer_pos + 2 < BUFFER_SIZE) {
-            buffer[buffer_pos++] = '\r';
-            buffer[buffer_pos++] = '\n';
-        }
+        append(entry.formatedMsg, strlen(entry.formatedMsg));
+    }
 
-        // 次のmsgで上書きされる。
-        buffer[buffer_pos] = '\0';
+    /**
+     * @brief 呼び出しスレッド専用のバッファを貸す
+     * @details フォーマッタはここへ1行を組み立て、commitで共有バッファへ渡す
+     * @param size 必要なバイト数（'\0'を含む）
+     * @return 書き込み先、スレッド専用バッファに収まらないサイズならnullptr
+     */
+    char* reserve(size_t size) override {
+        return size <= LOG_FMT_SIZE ? Memory::thread_staging() : nullptr;
+    }
 
-        // // 改行文字が含まれていたらフラッシュ
-        // if (strchr(entry.formatedMsg, '\n') != nullptr) {
-        //     flush();
-        // }
+    /**
+     * @brief reserveしたバッファの1行を共有バッファへ追加
+     * @param len 書き込んだ文字数
+     */
+    void commit(const LogEntry& entry, size_t len) override {
+        (void)entry;
+        append(Memory::thread_staging(), len);
     }
 
     /**
-     * @brief バッファの内容をクリア（基底クラスの処理）
+     * @brief 書き込み中のブロックを出力
+     * @details 呼び出し前に書き込みを終えた行は全て出力されてから戻る
      */
-    virtual void flush() {
-        // 基底クラスではバッファをクリアするのみ
-        // 実際の出力は継承先で実装
-        if (!is_empty()) {
-            clear_buffer();
+    void flush() override {
+        size_t gen = generation.load(std::memory_order_acquire);
+        size_t index = gen % count;
+        Block& block = blocks[index];
+        // 封印はCASで行う（fetch_addだと同時flushでSEALEDが重なり桁溢れする）
+        size_t used = block.reserved.load(std::memory_order_relaxed);
+        while (used != 0 && used <= capacity) {
+            if (block.reserved.compare_exchange_weak(
+                    used, SEALED, std::memory_order_acq_rel,
+                    std::memory_order_relaxed)) {
+                seal(index, used);
+                break;
+            }
+        }
+        // 空なら直前の世代まで、そうでなければこの世代まで出力を待つ
+        const size_t target = used == 0 ? gen : gen + 1;
+        while (released.load(std::memory_order_acquire) < target) {
+            drain(true);
+            std::this_thread::yield();
         }
     }
 
     /**
      * @brief デストラクタ - バッファをフラッシュ
      */
-    virtual ~BaseBufferedWriter() { flush(); }
+    virtual ~BaseBufferedWriter() {
+        flush();
+        Memory::aligned_bytes_delete(data);
+    }
 };
 
 /**
@@ -162,21 +418,431 @@ class BaseBufferedWriter : public IWriter {
  * @details BufferedWriterを継承してコンソール出力を実装
  */
 class BufferedWriter : public BaseBufferedWriter {
+   protected:
+    /**
+     * @brief バッファの内容を標準出力へ
+     */
+    void output(const Chunk* chunks, int n) override {
+        for (int i = 0; i < n; i++) {
+            fwrite(chunks[i].data, 1, chunks[i].len, stdout);
+        }
+    }
+
    public:
     /**
-     * @brief バッファの内容を出力してからクリア
+     * @brief デストラクタ - 残りを出力
+     * @details 基底のデストラクタからは派生のoutputが呼ばれないため
      */
-    void flush() override {
-        if (!is_empty()) {
-            // バッファの内容を出力
-            printf("%s", get_buffer());
-            // 親のflushを呼んでバッファをクリア
-            BaseBufferedWriter::flush();
+    ~BufferedWriter() override { flush(); }
+};
+
+#if LOG_FILE
+/**
+ * @brief FileWriterの永続化方針
+ * @details 書き込んだデータをいつfdatasyncでディスクへ落とすか
+ */
+struct SyncPolicy {
+    enum Mode {
+        NONE,         ///< 同期しない（OSに任せる）
+        EVERY_BYTES,  ///< valueバイト書く毎に同期
+        EVERY_MS,     ///< 前回の同期からvalueミリ秒経っていれば同期
+        ON_ERROR      ///< ERRORのレコード毎にflushして同期
+    };
+    Mode mode;
+    size_t value;
+
+    static SyncPolicy none() { return {NONE, 0}; }
+    static SyncPolicy every_bytes(size_t bytes) { return {EVERY_BYTES, bytes}; }
+    static SyncPolicy every_ms(size_t ms) { return {EVERY_MS, ms}; }
+    static SyncPolicy on_error() { return {ON_ERROR, 0}; }
+};
+
+/**
+ * @brief FileWriterのローテーション方針
+ * @details max_bytesとinterval_secはどちらか一方でも両方でもよい（0で無効）。
+ * 古いファイルはpath.1（最新）〜path.keepの名前で残し、それより古いものは
+ * 消す。compressはLOG_ZLIBが1のときだけ効き、path.N.gzになる
+ */
+struct RotatePolicy {
+    size_t max_bytes;      ///< このサイズを超える前に次のファイルへ切り替え
+    int64_t interval_sec;  ///< 壁時計でこの秒数の境界（UTC）を跨いだら切り替え
+    int keep;              ///< 残す古いファイルの数
+    bool compress;         ///< 古いファイルをgzipで圧縮
+
+    static RotatePolicy none() { return {0, 0, 0, false}; }
+    static RotatePolicy by_size(size_t bytes, int keep, bool compress = false) {
+        return {bytes, 0, keep, compress};
+    }
+    static RotatePolicy by_interval(int64_t sec, int keep,
+                                    bool compress = false) {
+        return {0, sec, keep, compress};
+    }
+    bool enabled() const { return max_bytes != 0 || interval_sec != 0; }
+};
+
+/**
+ * @brief ファイル出力クラス
+ * @details O_APPENDで開いたファイルディスクリプタへ直接書く（stdioを
+ * 通さない）。LOG_FILE_BUFFER_SIZEのブロックをLOG_FILE_BLOCKS個持ち、
+ * 溜まったブロックはwritevの1回でまとめて書き込む。
+ *
+ * RotatePolicyを渡すとサイズか時刻でファイルを切り替える。ローテーション
+ * スレッドが次のファイル（path.next）を先に開いておき、出力側はfdを
+ * 差し替えるだけにする。古いfdを閉じる、名前をずらす、圧縮する、古い
+ * ものを消すといった遅い処理は全てローテーションスレッドで行う。次の
+ * ファイルがまだ用意できていなければ切り替えは次のブロックまで見送り、
+ * ログを書くスレッドを待たせることはない
+ */
+class FileWriter : public BaseBufferedWriter {
+   private:
+    std::atomic<int> fd;  // 差し替えるのは出力スレッドのみ
+    SyncPolicy policy;
+    size_t unsynced = 0;  // 前回の同期以降に書いたバイト数（出力スレッドのみ）
+    std::atomic<int64_t> last_sync_ms;  // 前回の同期時刻（EVERY_MS）
+
+    // ローテーション
+    std::string path;
+    RotatePolicy rotation;
+    size_t file_bytes = 0;         // 今のファイルのサイズ（出力スレッドのみ）
+    int64_t next_rotate_sec = 0;   // 次の時刻境界（出力スレッドのみ）
+    std::atomic<int> spare_fd{-1};  // 用意済みの次のファイル
+    int retired_fd = -1;            // 閉じて名前をずらすファイル（mutexで保護）
+    bool stopping = false;
+    std::mutex rotate_mutex;
+    std::condition_variable rotate_cv;
+    std::thread rotator;
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static int64_t now_sec() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static void sync_fd(int target) {
+#if defined(__APPLE__)
+        fsync(target);
+#else
+        fdatasync(target);
+#endif
+    }
+
+    /**
+     * @brief 書き込み済みのデータをディスクへ同期
+     */
+    void sync() {
+        sync_fd(fd);
+        last_sync_ms.store(now_ms(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief n番目の古いファイルの名前（path.n、圧縮するならpath.n.gz）
+     */
+    std::string rotated_name(int n, bool gz) const {
+        return path + "." + std::to_string(n) + (gz ? ".gz" : "");
+    }
+
+    /**
+     * @brief 切り替えの時期なら用意済みのファイルへfdを差し替える
+     * @param bytes これから書くバイト数
+     * @details 出力スレッドから呼ばれる。ここで行うのは差し替えと通知だけ
+     */
+    void maybe_rotate(size_t bytes) {
+        bool due = (rotation.max_bytes != 0 && file_bytes != 0 &&
+                    file_bytes + bytes > rotation.max_bytes) ||
+                   (rotation.interval_sec != 0 && now_sec() >= next_rotate_sec);
+        if (!due) {
+            return;
+        }
+        int next = spare_fd.exchange(-1, std::memory_order_acquire);
+        if (next < 0) {
+            return;  // まだ用意できていない: 次のブロックで再試行
+        }
+        int old = fd.exchange(next);
+        file_bytes = 0;
+        if (rotation.interval_sec != 0) {
+            next_rotate_sec =
+                (now_sec() / rotation.interval_sec + 1) * rotation.interval_sec;
+        }
+        {
+            std::lock_guard<std::mutex> lock(rotate_mutex);
+            retired_fd = old;
+        }
+        rotate_cv.notify_one();
+    }
+
+    /**
+     * @brief 次のファイルをpath.nextとして開いておく
+     * @details 前回異常終了して残ったpath.nextは消さずに追記する
+     */
+    bool prepare_spare() {
+        std::string next = path + ".next";
+        int opened = ::open(next.c_str(),
+                            O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        spare_fd.store(opened, std::memory_order_release);
+        return opened >= 0;
+    }
+
+    /**
+     * @brief 切り替え前のファイルを閉じ、名前を1つずつずらす
+     * @details path.keepを消してpath.N→path.N+1とし、path→path.1、
+     * path.next→pathと付け替える。keepが0ならpath.nextでpathを置き換える。
+     * 圧縮に失敗して残った未圧縮のpath.Nもあるので、.Nと.N.gzの両方をずらす
+     * （残すファイルを付け替えで上書きしない）
+     */
+    void retire(int old) {
+        if (policy.mode != SyncPolicy::NONE) {
+            sync_fd(old);
+        }
+        ::close(old);
+        if (rotation.keep > 0) {
+#if LOG_ZLIB
+            // 前回の圧縮に失敗したpath.1は、ずらす前にもう一度圧縮する
+            if (rotation.compress) {
+                gzip_file(rotated_name(1, false), rotated_name(1, true));
+            }
+#endif
+            for (bool gz : {false, true}) {
+                remove(rotated_name(rotation.keep, gz).c_str());
+                for (int n = rotation.keep - 1; n >= 1; n--) {
+                    rename(rotated_name(n, gz).c_str(),
+                           rotated_name(n + 1, gz).c_str());
+                }
+            }
+            rename(path.c_str(), rotated_name(1, false).c_str());
+        }
+        rename((path + ".next").c_str(), path.c_str());
+    }
+
+#if LOG_ZLIB
+    /**
+     * @brief srcをgzip形式でdstへ圧縮し、成功したらsrcを消す
+     */
+    static void gzip_file(const std::string& src, const std::string& dst) {
+        int in = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            return;
+        }
+        gzFile out = gzopen(dst.c_str(), "wb");
+        bool ok = out != nullptr;
+        char buf[64 * 1024];
+        while (ok) {
+            ssize_t got = ::read(in, buf, sizeof(buf));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                ok = got == 0;
+                break;
+            }
+            ok = gzwrite(out, buf, static_cast<unsigned>(got)) == got;
+        }
+        if (out != nullptr && gzclose(out) != Z_OK) {
+            ok = false;
+        }
+        ::close(in);
+        remove(ok ? src.c_str() : dst.c_str());
+    }
+#endif
+
+    /**
+     * @brief ローテーションスレッド
+     * @details 次のファイルを用意し、差し替えられたファイルを片付ける。
+     * 片付けでは名前をずらしてすぐ次のファイルを用意し、圧縮はその後に行う
+     * （圧縮中も次の切り替えを待たせない）
+     */
+    void rotate_loop() {
+        // spare_fdが-1でも、渡した後なら出力側が使用中（まだpath.next）
+        bool need_spare = true;
+        std::unique_lock<std::mutex> lock(rotate_mutex);
+        while (true) {
+            if (need_spare) {
+                lock.unlock();
+                need_spare = !prepare_spare();
+                lock.lock();
+            }
+            // 開けなかった場合は1秒毎に開き直す
+            rotate_cv.wait_for(lock, std::chrono::seconds(1), [this] {
+                return stopping || retired_fd >= 0;
+            });
+            if (retired_fd >= 0) {
+                int old = retired_fd;
+                retired_fd = -1;
+                lock.unlock();
+                retire(old);
+                need_spare = !prepare_spare();
+#if LOG_ZLIB
+                if (rotation.compress && rotation.keep > 0) {
+                    gzip_file(rotated_name(1, false), rotated_name(1, true));
+                }
+#endif
+                lock.lock();
+                continue;
+            }
+            if (stopping) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief 全領域を書き切る（部分書き込みとEINTRは続きから再試行）
+     */
+    void write_all(struct iovec* iov, int n) {
+        while (n > 0) {
+            ssize_t done = ::writev(fd, iov, n);
+            if (done < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;  // 書けない（ディスクフルなど）: このブロックは捨てる
+            }
+            size_t left = static_cast<size_t>(done);
+            while (n > 0 && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                iov++;
+                n--;
+            }
+            if (n > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                iov->iov_len -= left;
+            }
+        }
+    }
+
+   protected:
+    /**
+     * @brief ERRORのレコードなら直ちにflushして同期（ON_ERROR）
+     * EVERY_MSでは間隔が過ぎていればflushして同期
+     */
+    void after_record(LogLevel level) {
+        if (policy.mode == SyncPolicy::ON_ERROR) {
+            if (level >= LogLevel::ERROR_) {
+                flush();
+                sync();
+            }
+        } else if (policy.mode == SyncPolicy::EVERY_MS) {
+            int64_t last = last_sync_ms.load(std::memory_order_relaxed);
+            if (now_ms() - last >= static_cast<int64_t>(policy.value) &&
+                last_sync_ms.compare_exchange_strong(
+                    last, now_ms(), std::memory_order_relaxed)) {
+                flush();
+                sync();
+            }
+        }
+    }
+
+    /**
+     * @brief 溜まったブロックをwritevでまとめて書く
+     */
+    void output(const Chunk* chunks, int n) override {
+        if (fd < 0) {
+            return;
+        }
+        struct iovec iov[MAX_BLOCKS];
+        size_t bytes = 0;
+        for (int i = 0; i < n; i++) {
+            iov[i].iov_base = const_cast<char*>(chunks[i].data);
+            iov[i].iov_len = chunks[i].len;
+            bytes += chunks[i].len;
+        }
+        if (rotation.enabled()) {
+            maybe_rotate(bytes);
+            file_bytes += bytes;
+        }
+        write_all(iov, n);
+        if (policy.mode == SyncPolicy::EVERY_BYTES) {
+            unsynced += bytes;
+            if (unsynced >= policy.value) {
+                sync();
+                unsynced = 0;
+            }
+        }
+    }
+
+   public:
+    /**
+     * @brief コンストラクタ
+     * @param path 出力先（無ければ作成、あれば末尾に追記）
+     * @param sync_policy 永続化方針
+     * @param rotate_policy ローテーション方針（既定はローテーションしない）
+     */
+    explicit FileWriter(const char* path,
+                        SyncPolicy sync_policy = SyncPolicy::none(),
+                        RotatePolicy rotate_policy = RotatePolicy::none())
+        : BaseBufferedWriter(LOG_FILE_BUFFER_SIZE, LOG_FILE_BLOCKS),
+          fd(::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)),
+          policy(sync_policy),
+          last_sync_ms(now_ms()),
+          path(path),
+          rotation(rotate_policy) {
+        if (fd < 0) {
+            printf("[ERROR_] ログファイルを開けません: %s\r\n", path);
+            return;
+        }
+        if (rotation.enabled()) {
+            off_t size = ::lseek(fd, 0, SEEK_END);
+            file_bytes = size > 0 ? static_cast<size_t>(size) : 0;
+            if (rotation.interval_sec != 0) {
+                next_rotate_sec = (now_sec() / rotation.interval_sec + 1) *
+                                  rotation.interval_sec;
+            }
+            rotator = std::thread(&FileWriter::rotate_loop, this);
+        }
+    }
+
+    /**
+     * @brief ファイルを開けたか
+     */
+    bool is_open() const { return fd >= 0; }
+
+    void write(const LogEntry& entry) override {
+        BaseBufferedWriter::write(entry);
+        after_record(entry.level);
+    }
+
+    void commit(const LogEntry& entry, size_t len) override {
+        BaseBufferedWriter::commit(entry, len);
+        after_record(entry.level);
+    }
+
+    /**
+     * @brief デストラクタ - 残りを書いて閉じる
+     */
+    ~FileWriter() override {
+        flush();
+        if (rotator.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(rotate_mutex);
+                stopping = true;
+            }
+            rotate_cv.notify_one();
+            rotator.join();  // 差し替え済みのファイルは片付けてから終わる
+            int spare = spare_fd.exchange(-1);
+            if (spare >= 0) {
+                bool unused = ::lseek(spare, 0, SEEK_END) == 0;
+                ::close(spare);
+                if (unused) {
+                    remove((path + ".next").c_str());
+                }
+            }
+        }
+        if (fd >= 0) {
+            if (policy.mode != SyncPolicy::NONE) {
+                sync();
+            }
+            ::close(fd);
         }
     }
 };
+#endif
 
 }  // namespace Writers
 }  // namespace logger
 
-#endif  // LOG_WRITERS_HPP
\ No newline at end of file
+#endif  // LOG_WRITERS_HPP
@@ -16,17 +16,123 @@
 #include <memory>   // スマートポインタ（std::unique_ptr, std::shared_ptr など）
 #include <mutex>  // 排他制御（std::mutex, std::lock_guard, std::once_flag など）
 #include <vector>  // 動的配列（std::vector）
-#include <map>     // 連想配列（std::map, std::multimap）
+#include <utility>  // std::pair
+#include <atomic>  // ロックフリー同期（std::atomic）
 
 constexpr size_t LOG_MSG_SIZE = 256;               // 入力メッセージ最大長
 constexpr size_t LOG_FMT_SIZE = LOG_MSG_SIZE * 2;  // フォーマット後
 constexpr size_t BUFFER_SIZE = 1024;               // バッファサイズ
 #define COL_CHECK 1
 
+// コンパイル時最小ログレベル: これ未満のLOG_*マクロは空に展開される
+// 0: DEBUG, 1: INFO, 2: WARN, 3: ERROR（LogLevelの並びと同じ）
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+// 非同期モード: 1でフォーマットと出力をバックエンドスレッドへ移す
+#ifndef LOG_ASYNC
+#define LOG_ASYNC 0
+#endif
+constexpr size_t LOG_QUEUE_SIZE = 1024;  // 非同期キューのスロット数（2の冪）
+
+// 遅延フォーマット: 1で呼び出し側は引数の生バイトを記録するだけにし、
+// printf相当の整形を後段へ移す（LOG_ASYNCと組み合わせて使う）
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 0
+#endif
+
+// ファイル出力: 1でFileWriter（POSIXのファイルディスクリプタ）を使える
+#ifndef LOG_FILE
+#if defined(__unix__) || defined(__APPLE__)
+#define LOG_FILE 1
+#else
+#define LOG_FILE 0
+#endif
+#endif
+constexpr size_t LOG_FILE_BUFFER_SIZE = 64 * 1024;  // FileWriterの1ブロック
+constexpr size_t LOG_FILE_BLOCKS = 4;  // FileWriterのブロック数（writevの最大数）
+constexpr size_t LOG_SEGMENT_SIZE = 16 * 1024 * 1024;  // MmapWriterの1セグメント
+
+// ローテーションしたファイルの圧縮: 1でzlibを使ってgzipにする（-lzが必要）
+#ifndef LOG_ZLIB
+#define LOG_ZLIB 0
+#endif
+
+// io_uring出力: 1でUringWriterを使える（Linuxのカーネルヘッダが必要）
+#ifndef LOG_URING
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define LOG_URING 1
+#endif
+#endif
+#endif
+#ifndef LOG_URING
+#define LOG_URING 0
+#endif
+constexpr size_t LOG_URING_BUFFER_SIZE = 256 * 1024;  // UringWriterの1ブロック
+constexpr size_t LOG_URING_BLOCKS = 4;  // UringWriterのブロック数（同時に書く数）
+// TSCの時計: 1でrdtscから時刻を取る（x86-64のGCC/Clang、不変TSCが必要）
+#ifndef LOG_TSC
+#if defined(__x86_64__) && defined(__GNUC__)
+#define LOG_TSC 1
+#else
+#define LOG_TSC 0
+#endif
+#endif
+constexpr int64_t LOG_TSC_CALIBRATION_US = 5000;  // 初回のTSC較正にかける時間
+constexpr int64_t LOG_TSC_REANCHOR_MS = 1000;  // TSCの時計を壁時計へ合わせ直す間隔
+
+constexpr size_t LOG_BINARY_SITES = 4096;  // BinaryFmtの辞書に載る呼び出し箇所数（2の冪）
+
+// 繰り返しの集約: 1で同じ呼び出し箇所・同じ引数が続いたレコードを
+// "last message repeated N times"の1行にまとめる
+#ifndef LOG_DEDUP
+#define LOG_DEDUP 0
+#endif
+constexpr size_t LOG_DEDUP_SITES = 1024;  // 集約を追跡する呼び出し箇所数（2の冪）
+constexpr uint64_t LOG_DEDUP_TIMEOUT_MS = 1000;  // 続いている間も途中経過を出す間隔
+
+constexpr size_t LOG_MAX_CHANNELS = 32;  // LOG_CHANNELで登録できるチャネル数（defaultを含む）
+constexpr size_t LOG_RCU_SLOTS = 128;  // 出力ペアを読むスレッドのスロット数（超えた分は共有カウンタ）
+// membarrier: 1で出力ペアを読む側のフェンスを差し替える側へ寄せる（Linux）
+#ifndef LOG_MEMBARRIER
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/membarrier.h>)
+#define LOG_MEMBARRIER 1
+#endif
+#endif
+#endif
+#ifndef LOG_MEMBARRIER
+#define LOG_MEMBARRIER 0
+#endif
+
 #include "log_type.hpp"
 #include "log_utils.hpp"
+#include "log_time.hpp"
+#include "log_rate.hpp"
+#include "log_channel.hpp"
+#include "log_sites.hpp"
+#include "log_pool.hpp"
+#include "log_rcu.hpp"
+#if LOG_DEFERRED
+#include "log_deferred.hpp"
+#endif
 #include "log_writers.hpp"
+#if LOG_FILE
+#include "log_mmap.hpp"
+#endif
+#if LOG_URING
+#include "log_uring.hpp"
+#endif
 #include "log_formatters.hpp"
+#include "log_binary.hpp"
+#if LOG_DEDUP
+#include "log_dedup.hpp"
+#endif
+#if LOG_ASYNC
+#include "log_async.hpp"
+#endif
 #include "log_core.hpp"
 
 // グローバル関数の実装
@@ -48,14 +154,18 @@ logger::Logger& get_logger() {
             std::make_unique<logger::Formatters::ConsoleFmt>(colored),
             std::make_unique<logger::Writers::BufferedWriter>());
 
-        // ペア2: ファイル出力（カラー無効）
+        // ペア2: ファイル出力（カラー無効、第3引数はこのペアの最小レベル）
         // pairs.emplace_back(
         //     std::make_unique<logger::Formatters::ConsoleFmt>(false),
-        //     std::make_unique<logger::Writers::FileWriter>("application.log"));
+        //     std::make_unique<logger::Writers::FileWriter>("application.log"),
+        //     LogLevel::DEBUG_);
 
         // Loggerインスタンスを作成
         instance = std::make_unique<logger::Logger>(std::move(pairs));
         instance->set_level(LogLevel::INFO_);
+#if LOG_ASYNC
+        instance->start_async();
+#endif
 
         instance->log_output(LogLevel::INFO_, __FILE__, __LINE__,
                              "Logger initialized with %d output destinations.",
@@ -70,25 +180,302 @@ logger::Logger& get_logger() {
     return *instance;
 }
 
-// ログ出力マクロ (カラータグ検証統合)
-#if COL_CHECK
-#define LOG_OUTPUT(level, fmt, ...)                                         \
+// 呼び出し箇所のヘッダをコンパイル時に描画し、CallSiteを定義する
+#define LOG_CALLSITE(name, level)                                             \
+    static constexpr auto name##header =                                      \
+        logger::Utils::SiteRenderer::render<                                  \
+            logger::Utils::SiteRenderer::header_size(                         \
+                __FILE__, __LINE__, level,                                    \
+                logger::Utils::SiteRenderer::CONSOLE)>(                       \
+            __FILE__, __LINE__, level, logger::Utils::SiteRenderer::CONSOLE); \
+    static constexpr auto name##brief =                                       \
+        logger::Utils::SiteRenderer::render<                                  \
+            logger::Utils::SiteRenderer::header_size(                         \
+                __FILE__, __LINE__, level,                                    \
+                logger::Utils::SiteRenderer::BRIEF)>(                         \
+            __FILE__, __LINE__, level, logger::Utils::SiteRenderer::BRIEF);   \
+    static constexpr logger::CallSite name = {                                \
+        level,                                                                \
+        logger::Utils::SiteRenderer::basename(__FILE__),                      \
+        __LINE__,                                                             \
+        name##header.data,                                                    \
+        static_cast<uint16_t>(sizeof(name##header.data) - 1),                 \
+        static_cast<uint8_t>(                                                 \
+            logger::Utils::SiteRenderer::level_width(level)),                 \
+        name##brief.data,                                                     \
+        static_cast<uint16_t>(sizeof(name##brief.data) - 1)}
+
+// フォーマット文字列の色タグをコンパイル時に変換し、FormatInfoを定義する
+// siteは呼び出し箇所（CallSite*、無ければnullptr）
+#define LOG_CT_FORMAT(name, fmt, site) LOG_CT_FORMAT_CH(name, fmt, site, nullptr)
+
+// チャネル付きのFormatInfoを定義する（channelはChannels::Channel*）
+#define LOG_CT_FORMAT_CH(name, fmt, site, channel)                            \
+    static constexpr auto name##ansi = logger::Utils::ColorTranslator::       \
+        translate<logger::Utils::ColorTranslator::translated_size(fmt, true)>( \
+            fmt, true);                                                       \
+    static constexpr auto name##plain = logger::Utils::ColorTranslator::      \
+        translate<logger::Utils::ColorTranslator::translated_size(fmt,        \
+                                                                  false)>(    \
+            fmt, false);                                                      \
+    static constexpr logger::FormatInfo name = {                              \
+        name##ansi.data,                                                      \
+        logger::Utils::ColorTranslator::has_static_tags(fmt)                  \
+            ? name##plain.data                                                \
+            : name##ansi.data,                                                \
+        logger::Utils::ColorTranslator::runtime_tags(fmt), site, channel}
+
+// 呼び出し箇所のスイッチ（Sites::Site）を定義する
+// 定数で初期化し（初期化ガードなし）、最初にSites::passesを通ったときに
+// 一覧へ繋ぐ
+#define LOG_SITE(name, site, fmt)                                     \
+    static logger::Sites::Site name = {site, fmt,                     \
+                                       {logger::Sites::UNLINKED |     \
+                                        logger::Sites::FOLLOW},       \
+                                       nullptr}
+
+// 指定したLoggerへのログ出力マクロ (カラータグ検証統合)
+// logはlogger::Logger、levelはLogLevel::*。
+// レベル判定（呼び出し箇所のスイッチで上書き可）を通ったときだけ
+// 引数が評価される
+#define LOG_TO(log, level, fmt, ...)                                        \
     do {                                                                    \
-        static_assert(logger::Utils::ValidationUtils::check_colors_ct(fmt), \
+        static_assert(!COL_CHECK ||                                         \
+                          logger::Utils::ValidationUtils::check_colors_ct(  \
+                              fmt),                                         \
                       "Invalid color tags");                                \
-        get_logger().log_output(level, __FILE__, __LINE__, fmt,             \
-                                ##__VA_ARGS__);                             \
+        LOG_CALLSITE(log_site_, level);                                     \
+        LOG_SITE(log_switch_, &log_site_, fmt);                             \
+        logger::Logger& log_ = (log);                                       \
+        if (logger::Sites::passes(log_switch_, log_.is_enabled(level))) {   \
+            LOG_CT_FORMAT(log_fmt_, fmt, &log_site_);                       \
+            log_.log_args(level, __FILE__, __LINE__, &log_fmt_,             \
+                          ##__VA_ARGS__);                                   \
+        }                                                                   \
     } while (0)
-#else
+
+// ログ出力マクロ（get_logger()へ出す）
 #define LOG_OUTPUT(level, fmt, ...) \
-    get_logger().log_output(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-#endif
+    LOG_TO(get_logger(), level, fmt, ##__VA_ARGS__)
+
+// 呼び出し箇所毎に間引くログ出力マクロ
+// Limiterはlogger::RateLimitのクラス、limitはallowへ渡す引数（括弧付き）。
+// レベル判定の後に判定し、捨てる場合はフォーマットも検証も行わない
+#define LOG_OUTPUT_LIMITED(level, Limiter, limit, fmt, ...)                 \
+    do {                                                                    \
+        static_assert(!COL_CHECK ||                                         \
+                          logger::Utils::ValidationUtils::check_colors_ct(  \
+                              fmt),                                         \
+                      "Invalid color tags");                                \
+        LOG_CALLSITE(log_site_, level);                                     \
+        LOG_SITE(log_switch_, &log_site_, fmt);                             \
+        logger::Logger& log_ = get_logger();                                \
+        if (logger::Sites::passes(log_switch_, log_.is_enabled(level))) {   \
+            static logger::RateLimit::Limiter log_rate_;                    \
+            if (log_rate_.allow limit) {                                    \
+                LOG_CT_FORMAT(log_fmt_, fmt, &log_site_);                   \
+                log_.log_args(level, __FILE__, __LINE__, &log_fmt_,         \
+                              ##__VA_ARGS__);                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+// メッセージを関数で作るログ出力マクロ
+// producerはレベル判定を通り、出力ペアがある場合だけ呼び出し側のスレッドで
+// 1回呼ばれる（void(logger::Utils::LineBuilder&)か、文字列を返す関数）。
+// ラムダの中のカンマで引数が分かれないよう可変長で受け取る
+#define LOG_OUTPUT_LAZY(level, ...)                                       \
+    do {                                                                  \
+        LOG_CALLSITE(log_site_, level);                                   \
+        LOG_SITE(log_switch_, &log_site_, "%s");                          \
+        logger::Logger& log_ = get_logger();                              \
+        uint8_t log_want_;                                                \
+        if (logger::Sites::passes(log_switch_,                            \
+                                  log_.is_enabled(level, log_want_)) &&   \
+            log_want_ != 0) {                                             \
+            LOG_CT_FORMAT(log_fmt_, "%s", &log_site_);                    \
+            log_.log_lazy(level, __FILE__, __LINE__, &log_fmt_,           \
+                          __VA_ARGS__);                                   \
+        }                                                                 \
+    } while (0)
+
+// チャネルを定義する（名前空間スコープで、使う翻訳単位毎に1回）
+// 例: LOG_CHANNEL(motor); → LOG_CH(motor, DEBUG, "rpm: %d", rpm);
+#define LOG_CHANNEL(ch) \
+    static const logger::Channels::Channel log_channel_##ch(#ch)
+
+// チャネル付きログ出力マクロ（levelはLogLevel::*）
+// Loggerのレベルではなくチャネルのレベルで判定し、チャネルの出力先の
+// ペアにだけ出す
+#define LOG_CH_OUTPUT(ch, level, fmt, ...)                                    \
+    do {                                                                      \
+        static_assert(!COL_CHECK ||                                           \
+                          logger::Utils::ValidationUtils::check_colors_ct(    \
+                              fmt),                                           \
+                      "Invalid color tags");                                  \
+        LOG_CALLSITE(log_site_, level);                                       \
+        LOG_SITE(log_switch_, &log_site_, fmt);                               \
+        if (logger::Sites::passes(                                            \
+                log_switch_,                                                  \
+                logger::Channels::enabled(log_channel_##ch, level))) {        \
+            LOG_CT_FORMAT_CH(log_fmt_, fmt, &log_site_, &log_channel_##ch);   \
+            get_logger().log_args(level, __FILE__, __LINE__, &log_fmt_,       \
+                                  ##__VA_ARGS__);                             \
+        }                                                                     \
+    } while (0)
+
+// 無効化されたマクロ（引数は評価されず、文字列もバイナリに残らない）
+// 色タグの検証はコンパイル時に行う（LOG_MIN_LEVELでビルドの可否が変わらない）
+#define LOG_DISABLED(fmt)                                                   \
+    do {                                                                    \
+        static_assert(!COL_CHECK ||                                         \
+                          logger::Utils::ValidationUtils::check_colors_ct(  \
+                              fmt),                                         \
+                      "Invalid color tags");                                \
+    } while (0)
 
 // ログレベル別マクロ
+#if LOG_MIN_LEVEL <= 0
 #define LOG_DEBUG(fmt, ...) LOG_OUTPUT(LogLevel::DEBUG_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 1
 #define LOG_INFO(fmt, ...) LOG_OUTPUT(LogLevel::INFO_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 2
 #define LOG_WARN(fmt, ...) LOG_OUTPUT(LogLevel::WARN_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 3
 #define LOG_ERROR(fmt, ...) LOG_OUTPUT(LogLevel::ERROR_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) LOG_DISABLED(fmt)
+#endif
+
+// チャネル付きログ出力マクロ（levelはDEBUG/INFO/WARN/ERROR）
+// LOG_MIN_LEVEL未満はLOG_<LEVEL>と同じく展開されない
+#define LOG_CH(ch, level, fmt, ...) LOG_CH_##level(ch, fmt, ##__VA_ARGS__)
+#if LOG_MIN_LEVEL <= 0
+#define LOG_CH_DEBUG(ch, fmt, ...) \
+    LOG_CH_OUTPUT(ch, LogLevel::DEBUG_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_CH_DEBUG(ch, fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 1
+#define LOG_CH_INFO(ch, fmt, ...) \
+    LOG_CH_OUTPUT(ch, LogLevel::INFO_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_CH_INFO(ch, fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define LOG_CH_WARN(ch, fmt, ...) \
+    LOG_CH_OUTPUT(ch, LogLevel::WARN_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_CH_WARN(ch, fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 3
+#define LOG_CH_ERROR(ch, fmt, ...) \
+    LOG_CH_OUTPUT(ch, LogLevel::ERROR_, fmt, ##__VA_ARGS__)
+#else
+#define LOG_CH_ERROR(ch, fmt, ...) LOG_DISABLED(fmt)
+#endif
+
+// 間引きマクロ（レベル別）
+//   LOG_<LEVEL>_EVERY_N(n, ...)          n回に1回（1回目を含む）
+//   LOG_<LEVEL>_FIRST_N(n, ...)          最初のn回だけ
+//   LOG_<LEVEL>_EVERY_MS(ms, ...)        ms毎に1回
+//   LOG_<LEVEL>_RATE(rate, burst, ...)   毎秒rate回、burst回まで連続可
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG_EVERY_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::DEBUG_, EveryN, (n), fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_FIRST_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::DEBUG_, FirstN, (n), fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_EVERY_MS(ms, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::DEBUG_, EveryMs, (ms), fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_RATE(rate, burst, fmt, ...)                             \
+    LOG_OUTPUT_LIMITED(LogLevel::DEBUG_, TokenBucket, (rate, burst), fmt, \
+                       ##__VA_ARGS__)
+#else
+#define LOG_DEBUG_EVERY_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_DEBUG_FIRST_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_DEBUG_EVERY_MS(ms, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_DEBUG_RATE(rate, burst, fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO_EVERY_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::INFO_, EveryN, (n), fmt, ##__VA_ARGS__)
+#define LOG_INFO_FIRST_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::INFO_, FirstN, (n), fmt, ##__VA_ARGS__)
+#define LOG_INFO_EVERY_MS(ms, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::INFO_, EveryMs, (ms), fmt, ##__VA_ARGS__)
+#define LOG_INFO_RATE(rate, burst, fmt, ...)                             \
+    LOG_OUTPUT_LIMITED(LogLevel::INFO_, TokenBucket, (rate, burst), fmt, \
+                       ##__VA_ARGS__)
+#else
+#define LOG_INFO_EVERY_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_INFO_FIRST_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_INFO_EVERY_MS(ms, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_INFO_RATE(rate, burst, fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define LOG_WARN_EVERY_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::WARN_, EveryN, (n), fmt, ##__VA_ARGS__)
+#define LOG_WARN_FIRST_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::WARN_, FirstN, (n), fmt, ##__VA_ARGS__)
+#define LOG_WARN_EVERY_MS(ms, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::WARN_, EveryMs, (ms), fmt, ##__VA_ARGS__)
+#define LOG_WARN_RATE(rate, burst, fmt, ...)                             \
+    LOG_OUTPUT_LIMITED(LogLevel::WARN_, TokenBucket, (rate, burst), fmt, \
+                       ##__VA_ARGS__)
+#else
+#define LOG_WARN_EVERY_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_WARN_FIRST_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_WARN_EVERY_MS(ms, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_WARN_RATE(rate, burst, fmt, ...) LOG_DISABLED(fmt)
+#endif
+#if LOG_MIN_LEVEL <= 3
+#define LOG_ERROR_EVERY_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::ERROR_, EveryN, (n), fmt, ##__VA_ARGS__)
+#define LOG_ERROR_FIRST_N(n, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::ERROR_, FirstN, (n), fmt, ##__VA_ARGS__)
+#define LOG_ERROR_EVERY_MS(ms, fmt, ...) \
+    LOG_OUTPUT_LIMITED(LogLevel::ERROR_, EveryMs, (ms), fmt, ##__VA_ARGS__)
+#define LOG_ERROR_RATE(rate, burst, fmt, ...)                             \
+    LOG_OUTPUT_LIMITED(LogLevel::ERROR_, TokenBucket, (rate, burst), fmt, \
+                       ##__VA_ARGS__)
+#else
+#define LOG_ERROR_EVERY_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_ERROR_FIRST_N(n, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_ERROR_EVERY_MS(ms, fmt, ...) LOG_DISABLED(fmt)
+#define LOG_ERROR_RATE(rate, burst, fmt, ...) LOG_DISABLED(fmt)
+#endif
+
+// 遅延生成マクロ（レベル別）
+//   LOG_<LEVEL>_LAZY(producer)  無効なレベルではproducerも評価されない
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG_LAZY(...) LOG_OUTPUT_LAZY(LogLevel::DEBUG_, __VA_ARGS__)
+#else
+#define LOG_DEBUG_LAZY(...) LOG_DISABLED("%s")
+#endif
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO_LAZY(...) LOG_OUTPUT_LAZY(LogLevel::INFO_, __VA_ARGS__)
+#else
+#define LOG_INFO_LAZY(...) LOG_DISABLED("%s")
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define LOG_WARN_LAZY(...) LOG_OUTPUT_LAZY(LogLevel::WARN_, __VA_ARGS__)
+#else
+#define LOG_WARN_LAZY(...) LOG_DISABLED("%s")
+#endif
+#if LOG_MIN_LEVEL <= 3
+#define LOG_ERROR_LAZY(...) LOG_OUTPUT_LAZY(LogLevel::ERROR_, __VA_ARGS__)
+#else
+#define LOG_ERROR_LAZY(...) LOG_DISABLED("%s")
+#endif
 
 #define FLUSH_BUFF() get_logger().flush()
 
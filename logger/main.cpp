@@ -27,8 +27,11 @@ int main() {
 
     LOG_INFO("Logger color tag test: p|red| g|green| t|yellow| b|blue|.");
 
-    const char* msg = colorString("Hello, world! testing colorfull text!");
-    LOG_INFO("String test: %s", msg);
+    // 文字列の生成はINFOが有効なときだけ行われる
+    LOG_INFO_LAZY([](logger::Utils::LineBuilder& out) {
+        out.append("String test: ");
+        out.append(colorString("Hello, world! testing colorfull text!"));
+    });
 
     for (int i = 0; i < 10; ++i) {
         float value = static_cast<float>(std::rand()) / RAND_MAX * 100.0f;
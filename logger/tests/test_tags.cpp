@@ -0,0 +1,90 @@
+// test_tags.cpp
+// 色タグの実行時処理のテスト
+// 引数（%s）由来の不正な色タグがLOG_*でERROR_の"Invalid color tags"行に
+// なること、正しいタグが変換・除去されることを確認する
+// （失敗すれば終了コード1）。
+//
+//   g++ -std=c++14 -O2 tests/test_tags.cpp -o test_tags
+//   ./test_tags
+
+#include "../logger.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @brief 出力された行を溜めるwriter
+ */
+class CaptureWriter : public logger::Writers::BaseBufferedWriter {
+   public:
+    std::string text;
+
+    ~CaptureWriter() override { flush(); }
+
+   protected:
+    void output(const Chunk* chunks, int n) override {
+        for (int i = 0; i < n; i++) {
+            text.append(chunks[i].data, chunks[i].len);
+        }
+    }
+};
+
+/**
+ * @brief 引数由来の色タグがLOG_*で検証されることを確認
+ * @details 不正なタグはERROR_の"Invalid color tags"になり、色が後の行へ
+ * 漏れない。正しいタグは変換・除去される
+ * @return 全て期待通りならtrue
+ */
+static bool check_arg_tags() {
+    using namespace logger;
+    CaptureWriter* console = new CaptureWriter();
+    CaptureWriter* plain = new CaptureWriter();
+    std::vector<std::shared_ptr<LoggerPair>> pairs;
+    pairs.push_back(std::make_shared<LoggerPair>(
+        std::unique_ptr<Formatters::FormatterBase>(
+            new Formatters::ConsoleFmt(true)),
+        std::unique_ptr<Writers::IWriter>(console)));
+    pairs.push_back(std::make_shared<LoggerPair>(
+        std::unique_ptr<Formatters::FormatterBase>(new Formatters::PlainFmt()),
+        std::unique_ptr<Writers::IWriter>(plain)));
+    get_logger().replace_pairs(std::move(pairs));
+
+    LOG_INFO("arg: %s", "r|abc");     // 閉じていない
+    LOG_INFO("arg: %s", "q|abc|");    // 未定義の色
+    LOG_INFO("arg: %s", "r|abc|");    // 正しい
+    get_logger().flush();
+
+    struct Expect {
+        const std::string& text;
+        const char* needle;
+        bool present;
+    } expects[] = {
+        {console->text, "Invalid color tags", true},
+        {console->text, "\033[31mabc\r", false},
+        {console->text, "q|abc|", false},
+        {console->text, "arg: \033[31mabc\033[0m", true},
+        {plain->text, "[ERROR] test_tags.cpp", true},
+        {plain->text, "arg: abc\r", true},
+    };
+    bool ok = true;
+    for (const Expect& e : expects) {
+        if ((e.text.find(e.needle) != std::string::npos) != e.present) {
+            printf("ARG TAGS: %s \"%s\"\n",
+                   e.present ? "missing" : "unexpected", e.needle);
+            ok = false;
+        }
+    }
+    size_t errors = 0;
+    for (size_t pos = 0; (pos = plain->text.find("Invalid color tags", pos)) !=
+                         std::string::npos;
+         pos++) {
+        errors++;
+    }
+    if (errors != 2) {
+        printf("ARG TAGS: %zu invalid lines (expected 2)\n", errors);
+        ok = false;
+    }
+    printf("arg tags: %s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() { return check_arg_tags() ? 0 : 1; }
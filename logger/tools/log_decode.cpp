@@ -0,0 +1,188 @@
+// log_decode.cpp
+// バイナリログ（BinaryFmt + BinaryFileWriter）をテキストに戻すツール
+// ファイルをmmapし、先頭から辞書レコードとチャンクの境界だけを拾った後、
+// チャンク毎に複数スレッドでConsoleFmt/PlainFmtを使って描画する
+// （出力順はファイル内の順のまま）。
+//
+//   g++ -std=c++14 -O2 -pthread tools/log_decode.cpp -o log_decode
+//   ./log_decode [-p|-m] [-t] [-j スレッド数] app.bin
+//
+//   -p  PlainFmtで描画（既定はConsoleFmtのカラー）
+//   -m  ConsoleFmtのカラーなし
+//   -t  行頭に時刻（ローカル時刻、マイクロ秒まで）を付ける
+//
+// 終了コード: 0 全て描画, 1 途切れた・壊れたレコードや辞書に無いIDがある
+
+#include "../logger.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace logger;
+
+namespace {
+
+const size_t CHUNK_BYTES = 1 << 20;  // 1スレッドが1度に描画する量
+
+enum Style { COLOR, MONO, PLAIN };
+
+/**
+ * @brief レコードの境界で切った描画単位
+ */
+struct Chunk {
+    size_t begin;
+    size_t end;
+    size_t session;  // 使う辞書
+};
+
+/**
+ * @brief 1チャンクを描画
+ * @return 描画できなかったレコード数
+ */
+size_t decode_chunk(const char* data, const Chunk& chunk,
+                    const Binary::Dictionary& dictionary, Style style,
+                    bool timestamps, std::string& out) {
+    const Time::Precision time =
+        timestamps ? Time::Precision::MICROS : Time::Precision::NONE;
+    std::unique_ptr<Formatters::FormatterBase> formatter;
+    if (style == PLAIN) {
+        formatter.reset(new Formatters::PlainFmt(time));
+    } else {
+        formatter.reset(new Formatters::ConsoleFmt(style == COLOR, time));
+    }
+    size_t failed = 0;
+    char line[LOG_FMT_SIZE];
+    out.reserve((chunk.end - chunk.begin) * 3);
+
+    Binary::Record rec;
+    const char* end = data + chunk.end;
+    for (const char* p = data + chunk.begin; p < end;) {
+        p += Binary::parse(p, end, rec);  // 索引作成時に検証済み
+        if (rec.kind != Binary::DATA && rec.kind != Binary::TEXT) {
+            continue;
+        }
+        size_t len =
+            Binary::render(rec, dictionary, *formatter, line, sizeof(line));
+        if (len == 0) {
+            failed++;
+            continue;
+        }
+        out.append(line, len);
+        out.append("\r\n", 2);
+    }
+    return failed;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Style style = COLOR;
+    bool timestamps = false;
+    unsigned jobs = std::thread::hardware_concurrency();
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0) {
+            style = PLAIN;
+        } else if (strcmp(argv[i], "-m") == 0) {
+            style = MONO;
+        } else if (strcmp(argv[i], "-t") == 0) {
+            timestamps = true;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = static_cast<unsigned>(atoi(argv[++i]));
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr) {
+        fprintf(stderr, "usage: %s [-p|-m] [-t] [-j threads] file\n", argv[0]);
+        return 1;
+    }
+    if (jobs == 0) {
+        jobs = 1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 1;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: cannot map\n", path);
+        return 1;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(map);
+
+    // 索引: レコード長を辿りながら辞書とチャンクの境界を集める
+    std::vector<Binary::Dictionary> sessions;
+    std::vector<Chunk> chunks;
+    int status = 0;
+    size_t pos = 0;
+    size_t chunk_begin = 0;
+    Binary::Record rec;
+    while (pos < size) {
+        size_t len = Binary::parse(data + pos, data + size, rec);
+        if (len == 0 || (sessions.empty() && rec.kind != Binary::SESSION)) {
+            fprintf(stderr, "%s: damaged or truncated record at offset %zu\n",
+                    path, pos);
+            status = 1;
+            break;
+        }
+        if (rec.kind == Binary::SESSION) {
+            if (pos > chunk_begin && !sessions.empty()) {
+                chunks.push_back({chunk_begin, pos, sessions.size() - 1});
+            }
+            sessions.emplace_back();
+            chunk_begin = pos;
+        } else if (rec.kind == Binary::FORMAT) {
+            sessions.back().add(rec);
+        }
+        pos += len;
+        if (pos - chunk_begin >= CHUNK_BYTES) {
+            chunks.push_back({chunk_begin, pos, sessions.size() - 1});
+            chunk_begin = pos;
+        }
+    }
+    if (pos > chunk_begin && !sessions.empty()) {
+        chunks.push_back({chunk_begin, pos, sessions.size() - 1});
+    }
+
+    // jobs個ずつ並列に描画し、順番に書き出す
+    std::vector<std::string> outputs(jobs);
+    std::vector<size_t> failed(jobs);
+    for (size_t first = 0; first < chunks.size(); first += jobs) {
+        size_t count = std::min<size_t>(jobs, chunks.size() - first);
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < count; i++) {
+            outputs[i].clear();
+            const Chunk& chunk = chunks[first + i];
+            workers.emplace_back([&, i, chunk] {
+                failed[i] = decode_chunk(data, chunk, sessions[chunk.session],
+                                         style, timestamps, outputs[i]);
+            });
+        }
+        for (size_t i = 0; i < count; i++) {
+            workers[i].join();
+            fwrite(outputs[i].data(), 1, outputs[i].size(), stdout);
+            if (failed[i] != 0) {
+                fprintf(stderr, "%s: %zu records refer to unknown formats\n",
+                        path, failed[i]);
+                status = 1;
+            }
+        }
+    }
+    munmap(map, size);
+    return status;
+}